@@ -29,7 +29,9 @@
 #include "Pathfinding.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Logger.h"
+#include "../Engine/ThreadPool.h"
 #include "../Engine/Game.h"
+#include "../Engine/Trace.h"
 #include "../Mod/Armor.h"
 #include "../Mod/Mod.h"
 #include "../Mod/RuleItem.h"
@@ -38,6 +40,40 @@
 namespace OpenXcom
 {
 
+namespace
+{
+
+/**
+ * Values for the candidates of a search, worked out ahead of the search
+ * on the worker threads, one batch at a time as the search asks for them.
+ * The function must only read the battle, it runs in parallel.
+ */
+class SearchLookahead
+{
+	std::function<int(int)> _func;
+	std::vector<int> _values;
+	int _ready, _batch;
+public:
+	/// Creates a lookahead for a number of candidates.
+	SearchLookahead(int count, std::function<int(int)> func) : _func(std::move(func)), _values(count), _ready(0)
+	{
+		int threads = ThreadPool::getThreadCount();
+		_batch = threads > 1 ? threads * 4 : 1;
+	}
+	/// Gets the value for a candidate.
+	int get(int index)
+	{
+		if (index >= _ready)
+		{
+			int first = _ready;
+			_ready = std::min(std::max(index + 1, first + _batch), (int)_values.size());
+			ThreadPool::parallelFor(_ready - first, [&](int i){ _values[first + i] = _func(first + i); });
+		}
+		return _values[index];
+	}
+};
+
+}
 
 /**
  * Sets up a BattleAIState.
@@ -421,10 +457,11 @@ bool AIModule::medikit_think(BattleMediKitType healOrStim)
  */
 void AIModule::think(BattleAction *action)
 {
+	TRACE_ZONE("AIModule::think");
 	action->type = BA_RETHINK;
 	action->actor = _unit;
 	action->weapon = _unit->getMainHandWeapon(false);
-	_attackAction.diff = _save->getBattleState()->getGame()->getSavedGame()->getDifficultyCoefficient();
+	_attackAction.diff = _save->getGeoscapeSave()->getDifficultyCoefficient();
 	_attackAction.actor = _unit;
 	_attackAction.run = false;
 	_attackAction.weapon = action->weapon;
@@ -918,6 +955,7 @@ void AIModule::setupAmbush()
 		Position origin = _save->getTileEngine()->getSightOriginVoxel(_aggroTarget);
 
 		// we'll use node positions for this, as it gives map makers a good degree of control over how the units will use the environment.
+		std::vector<Position> candidates;
 		for (const auto* node : *_save->getNodes())
 		{
 			if (node->isDummy())
@@ -929,6 +967,23 @@ void AIModule::setupAmbush()
 			if (tile == 0 || Position::distance2d(pos, _unit->getPosition()) > 10 || pos.z != _unit->getPosition().z || tile->getDangerous() ||
 				std::find(_reachableWithAttack.begin(), _reachableWithAttack.end(), _save->getTileIndex(pos))  == _reachableWithAttack.end())
 				continue; // just ignore unreachable tiles
+			candidates.push_back(pos);
+		}
+
+		// make sure we can't be seen there.
+		std::vector<Spotter> spotters = getSpotters();
+		SearchLookahead hidden((int)candidates.size(), [&](int i) -> int
+		{
+			Position eyes = origin;
+			Position target;
+			Tile *tile = _save->getTile(candidates[i]);
+			return !_save->getTileEngine()->canTargetUnit(&eyes, tile, &target, _aggroTarget, false, _unit) && !countSpotters(spotters, candidates[i]);
+		});
+
+		for (int i = 0; i < (int)candidates.size(); ++i)
+		{
+			Position pos = candidates[i];
+			Tile *tile = _save->getTile(pos);
 
 			if (_traceAI)
 			{
@@ -937,9 +992,7 @@ void AIModule::setupAmbush()
 				tile->setMarkerColor(13);
 			}
 
-			// make sure we can't be seen here.
-			Position target;
-			if (!_save->getTileEngine()->canTargetUnit(&origin, tile, &target, _aggroTarget, false, _unit) && !getSpottingUnits(pos))
+			if (hidden.get(i))
 			{
 				_save->getPathfinding()->calculate(_unit, pos, BAM_NORMAL);
 				int ambushTUs = _save->getPathfinding()->getTotalTUCost();
@@ -1113,7 +1166,8 @@ void AIModule::setupAttack()
  */
 void AIModule::setupEscape()
 {
-	int unitsSpottingMe = getSpottingUnits(_unit->getPosition());
+	std::vector<Spotter> enemies = getSpotters();
+	int unitsSpottingMe = countSpotters(enemies, _unit->getPosition());
 	int currentTilePreference = 15;
 	int tries = -1;
 	bool coverFound = false;
@@ -1139,6 +1193,22 @@ void AIModule::setupEscape()
 	std::vector<Position> randomTileSearch = _save->getTileSearch();
 	RNG::shuffle(randomTileSearch);
 
+	// the exposure of the systematic search tiles doesn't depend on the search itself
+	std::vector<Position> searchTiles;
+	for (const auto& randomPosition : randomTileSearch)
+	{
+		searchTiles.push_back(_unit->getPosition() + Position(randomPosition.x, randomPosition.y, 0));
+	}
+	SearchLookahead searchSpotters((int)searchTiles.size(), [&](int i)
+	{
+		const Position &pos = searchTiles[i];
+		if (!_save->getTile(pos) || std::find(_reachable.begin(), _reachable.end(), _save->getTileIndex(pos)) == _reachable.end())
+		{
+			return 0;
+		}
+		return countSpotters(enemies, pos);
+	});
+
 	while (tries < 150 && !coverFound)
 	{
 		_escapeAction.target = _unit->getPosition(); // start looking in a direction away from the enemy
@@ -1150,6 +1220,7 @@ void AIModule::setupEscape()
 		}
 
 		score = 0;
+		int searchIndex = -1;
 
 		if (tries == -1)
 		{
@@ -1165,6 +1236,7 @@ void AIModule::setupEscape()
 			// looking for cover
 			_escapeAction.target.x += randomTileSearch[tries].x;
 			_escapeAction.target.y += randomTileSearch[tries].y;
+			searchIndex = tries;
 			score = BASE_SYSTEMATIC_SUCCESS;
 			if (_escapeAction.target == _unit->getPosition())
 			{
@@ -1225,7 +1297,14 @@ void AIModule::setupEscape()
 		}
 		else
 		{
-			spotters = getSpottingUnits(_escapeAction.target);
+			if (searchIndex != -1 && _escapeAction.target == searchTiles[searchIndex])
+			{
+				spotters = searchSpotters.get(searchIndex);
+			}
+			else
+			{
+				spotters = countSpotters(enemies, _escapeAction.target);
+			}
 			if (std::find(_reachable.begin(), _reachable.end(), _save->getTileIndex(_escapeAction.target))  == _reachable.end())
 				continue; // just ignore unreachable tiles
 
@@ -1337,32 +1416,52 @@ int AIModule::countKnownTargets() const
  */
 int AIModule::getSpottingUnits(const Position& pos) const
 {
-	// if we don't actually occupy the position being checked, we need to do a virtual LOF check.
-	bool checking = pos != _unit->getPosition();
-	int tally = 0;
+	return countSpotters(getSpotters(), pos);
+}
+
+/**
+ * Lists the enemies (xcom only) that are taken into account by getSpottingUnits.
+ * Target weights can run scripts, so this is done once on the main thread
+ * before checking many positions.
+ * @return Enemies and their eye positions.
+ */
+std::vector<AIModule::Spotter> AIModule::getSpotters() const
+{
+	std::vector<Spotter> spotters;
 	for (auto* bu : *_save->getUnits())
 	{
 		if (validTarget(bu, false, false))
 		{
-			int dist = Position::distance2d(pos, bu->getPosition());
-			if (dist > 20) continue;
 			Position originVoxel = _save->getTileEngine()->getSightOriginVoxel(bu);
 			originVoxel.z -= 2;
-			Position targetVoxel;
-			if (checking)
-			{
-				if (_save->getTileEngine()->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, bu, false, _unit))
-				{
-					tally++;
-				}
-			}
-			else
-			{
-				if (_save->getTileEngine()->canTargetUnit(&originVoxel, _save->getTile(pos), &targetVoxel, bu, false))
-				{
-					tally++;
-				}
-			}
+			spotters.push_back({ bu, originVoxel });
+		}
+	}
+	return spotters;
+}
+
+/**
+ * Counts how many of the given enemies are spotting a position.
+ * Only reads the battle, so it can run on worker threads.
+ * @param spotters Enemies from getSpotters.
+ * @param pos The Position to check for spotters.
+ * @return spotters.
+ */
+int AIModule::countSpotters(const std::vector<Spotter> &spotters, const Position& pos) const
+{
+	// if we don't actually occupy the position being checked, we need to do a virtual LOF check.
+	BattleUnit *potentialUnit = pos != _unit->getPosition() ? _unit : nullptr;
+	Tile *tile = _save->getTile(pos);
+	int tally = 0;
+	for (const auto& spotter : spotters)
+	{
+		int dist = Position::distance2d(pos, spotter.unit->getPosition());
+		if (dist > 20) continue;
+		Position originVoxel = spotter.originVoxel;
+		Position targetVoxel;
+		if (_save->getTileEngine()->canTargetUnit(&originVoxel, tile, &targetVoxel, spotter.unit, false, potentialUnit))
+		{
+			tally++;
 		}
 	}
 	return tally;
@@ -2049,13 +2148,13 @@ bool AIModule::findFirePoint()
 		return false;
 	std::vector<Position> randomTileSearch = _save->getTileSearch(); // copy!
 	RNG::shuffle(randomTileSearch);
-	Position target;
 	const int BASE_SYSTEMATIC_SUCCESS = 100;
 	const int FAST_PASS_THRESHOLD = 125;
 	bool waitIfOutsideWeaponRange = _unit->getGeoscapeSoldier() ? false : _unit->getUnitRules()->waitIfOutsideWeaponRange();
 	bool extendedFireModeChoiceEnabled = _save->getMod()->getAIExtendedFireModeChoice();
 	int bestScore = 0;
 	_attackAction.type = BA_RETHINK;
+	std::vector<Position> candidates;
 	for (const auto& randomPosition : randomTileSearch)
 	{
 		Position pos = _unit->getPosition() + randomPosition;
@@ -2063,19 +2162,38 @@ bool AIModule::findFirePoint()
 		if (tile == 0  ||
 			std::find(_reachableWithAttack.begin(), _reachableWithAttack.end(), _save->getTileIndex(pos))  == _reachableWithAttack.end())
 			continue;
-		int score = 0;
+		candidates.push_back(pos);
+	}
+
+	// number of spotters of each candidate we can shoot from, or -1 if we can't
+	std::vector<Spotter> spotters = getSpotters();
+	SearchLookahead exposure((int)candidates.size(), [&](int i)
+	{
+		const Position &pos = candidates[i];
 		// i should really make a function for this
 		Position origin = pos.toVoxel() +
 			// 4 because -2 is eyes and 2 below that is the rifle (or at least that's my understanding)
-			Position(8,8, _unit->getHeight() + _unit->getFloatHeight() - tile->getTerrainLevel() - 4);
+			Position(8,8, _unit->getHeight() + _unit->getFloatHeight() - _save->getTile(pos)->getTerrainLevel() - 4);
+		Position scanVoxel;
+		if (!_save->getTileEngine()->canTargetUnit(&origin, _aggroTarget->getTile(), &scanVoxel, _unit, false))
+		{
+			return -1;
+		}
+		return countSpotters(spotters, pos);
+	});
 
-		if (_save->getTileEngine()->canTargetUnit(&origin, _aggroTarget->getTile(), &target, _unit, false))
+	for (int i = 0; i < (int)candidates.size(); ++i)
+	{
+		Position pos = candidates[i];
+		int score = 0;
+		int spotting = exposure.get(i);
+		if (spotting != -1)
 		{
 			_save->getPathfinding()->calculate(_unit, pos, BAM_NORMAL);
 			// can move here
 			if (_save->getPathfinding()->getStartDirection() != -1)
 			{
-				score = BASE_SYSTEMATIC_SUCCESS - getSpottingUnits(pos) * 10;
+				score = BASE_SYSTEMATIC_SUCCESS - spotting * 10;
 				score += _unit->getTimeUnits() - _save->getPathfinding()->getTotalTUCost();
 				if (!_aggroTarget->checkViewSector(pos))
 				{
@@ -2148,7 +2266,7 @@ int AIModule::explosiveEfficacy(Position targetPos, BattleUnit *attackingUnit, i
 
 	if (diff == -1)
 	{
-		diff = _save->getBattleState()->getGame()->getSavedGame()->getDifficultyCoefficient();
+		diff = _save->getGeoscapeSave()->getDifficultyCoefficient();
 	}
 	int distance = Position::distance2d(attackingUnit->getPosition(), targetPos);
 	int injurylevel = attackingUnit->getBaseStats()->health - attackingUnit->getHealth();
@@ -64,6 +64,17 @@ private:
 
 	BattleAction _escapeAction, _ambushAction, _attackAction, _patrolAction, _psiAction;
 
+	/// Enemy that counts for getSpottingUnits, with its eye voxel.
+	struct Spotter
+	{
+		BattleUnit *unit;
+		Position originVoxel;
+	};
+
+	/// Lists the enemies that could spot us.
+	std::vector<Spotter> getSpotters() const;
+	/// Counts the spotters able to see a position, safe to call from worker threads.
+	int countSpotters(const std::vector<Spotter> &spotters, const Position& pos) const;
 	bool selectPointNearTargetLeeroy(BattleUnit *target, bool canRun);
 	int selectNearestTargetLeeroy(bool canRun);
 	void meleeActionLeeroy(bool canRun);
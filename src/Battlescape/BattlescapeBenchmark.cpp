@@ -0,0 +1,315 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BattlescapeBenchmark.h"
+#include <chrono>
+#include <iomanip>
+#include "AIModule.h"
+#include "Pathfinding.h"
+#include "TileEngine.h"
+#include "../Engine/CrossPlatform.h"
+#include "../Engine/Logger.h"
+#include "../Mod/Armor.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Sets up a benchmark for a battle.
+ * @param save Pointer to the battle, with map resources and utilities already loaded.
+ */
+BattlescapeBenchmark::BattlescapeBenchmark(SavedBattleGame *save) : _save(save), _phaseTime(), _totalTime(0.0),
+	_turns(0), _decisions(0), _steps(0), _attacks(0), _reactions(0)
+{
+}
+
+/**
+ * Deletes the benchmark.
+ */
+BattlescapeBenchmark::~BattlescapeBenchmark()
+{
+
+}
+
+/**
+ * Calls a function and adds the time it took to a phase.
+ * @param phase Phase the work belongs to.
+ * @param func Work to measure.
+ */
+template<typename F>
+void BattlescapeBenchmark::measure(BenchmarkPhase phase, F &&func)
+{
+	auto start = std::chrono::steady_clock::now();
+	func();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	_phaseTime[phase] += elapsed.count();
+}
+
+/**
+ * Plays full turns (player, hostile and neutral side) with the AI in control of every unit.
+ * @param turns Number of turns to play.
+ */
+void BattlescapeBenchmark::run(int turns)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < turns; ++i)
+	{
+		do
+		{
+			playSide();
+			endTurn();
+		}
+		while (_save->getSide() != FACTION_PLAYER);
+		++_turns;
+		Log(LOG_INFO) << "Benchmark turn " << _turns << "/" << turns << " done.";
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	_totalTime += elapsed.count();
+}
+
+/**
+ * Lets every unit of the current side think and act, in unit order.
+ */
+void BattlescapeBenchmark::playSide()
+{
+	UnitFaction side = _save->getSide();
+	// units can't be added by our simplified actions, but don't rely on iterators anyway
+	for (size_t i = 0; i < _save->getUnits()->size(); ++i)
+	{
+		BattleUnit *unit = _save->getUnits()->at(i);
+		if (unit->getFaction() != side || unit->isOut() || unit->isIgnored())
+		{
+			continue;
+		}
+		playUnit(unit);
+	}
+	_save->setSelectedUnit(nullptr);
+}
+
+/**
+ * Runs the AI of a unit, the same way BattlescapeGame::handleAI does: up to two actions per turn.
+ * @param unit Unit to play.
+ */
+void BattlescapeBenchmark::playUnit(BattleUnit *unit)
+{
+	if (!unit->getAIModule())
+	{
+		unit->setAIModule(new AIModule(_save, unit, 0));
+		if (unit->getFaction() == FACTION_PLAYER)
+		{
+			unit->getAIModule()->setTargetFaction(FACTION_HOSTILE);
+		}
+	}
+	_save->setSelectedUnit(unit);
+	_save->resetUnitHitStates();
+
+	for (int number = 1; number <= 2 && unit->getTimeUnits() > 5 && !unit->isOut(); ++number)
+	{
+		measure(BP_FOV, [&]{ _save->getTileEngine()->calculateFOV(unit->getPosition(), 1, false); });
+
+		BattleAction action;
+		action.actor = unit;
+		action.number = number;
+		measure(BP_AI, [&]
+		{
+			unit->think(&action);
+			if (action.type == BA_RETHINK)
+			{
+				unit->think(&action);
+			}
+		});
+		++_decisions;
+
+		switch (action.type)
+		{
+		case BA_WALK:
+			walk(unit, action);
+			break;
+		case BA_SNAPSHOT:
+		case BA_AUTOSHOT:
+		case BA_AIMEDSHOT:
+		case BA_THROW:
+		case BA_HIT:
+		case BA_MINDCONTROL:
+		case BA_USE:
+		case BA_PANIC:
+		case BA_LAUNCH:
+			action.updateTU();
+			if (!action.spendTU())
+			{
+				return;
+			}
+			++_attacks;
+			break;
+		default:
+			return;
+		}
+	}
+}
+
+/**
+ * Moves a unit tile by tile along its path, doing the same per-step
+ * work as UnitWalkBState: doors, lighting, visibility and reaction checks.
+ * @param unit Walking unit.
+ * @param action Walk action with the destination.
+ */
+void BattlescapeBenchmark::walk(BattleUnit *unit, const BattleAction &action)
+{
+	Pathfinding *pf = _save->getPathfinding();
+	TileEngine *te = _save->getTileEngine();
+	int size = unit->getArmor()->getSize() - 1;
+	size_t spotted = unit->getUnitsSpottedThisTurn().size();
+
+	if (!_save->getTile(action.target))
+	{
+		return;
+	}
+	measure(BP_PATHFINDING, [&]{ pf->calculate(unit, action.target, action.getMoveType()); });
+
+	int dir;
+	while ((dir = pf->getStartDirection()) != -1 && !unit->isOut())
+	{
+		pf->setUnit(unit);
+		PathfindingStep step = pf->getTUCost(unit->getPosition(), dir, unit, 0, action.getMoveType());
+		if (step.cost.time == Pathfinding::INVALID_MOVE_COST || step.cost.time > unit->getTimeUnits() || step.cost.energy > unit->getEnergy())
+		{
+			break;
+		}
+		if (dir < Pathfinding::DIR_UP)
+		{
+			if (dir != unit->getDirection())
+			{
+				unit->lookAt(dir);
+				while (unit->getStatus() == STATUS_TURNING)
+				{
+					unit->turn();
+				}
+			}
+			int door = te->unitOpensDoor(unit, false, dir);
+			if (door == 4 || door == 5)
+			{
+				break;
+			}
+		}
+		bool blocked = false;
+		for (int x = size; x >= 0; --x)
+		{
+			for (int y = size; y >= 0; --y)
+			{
+				BattleUnit *other = _save->getTile(step.pos + Position(x, y, 0))->getOverlappingUnit(_save, TUO_IGNORE_SMALL);
+				blocked = blocked || (other && other != unit);
+			}
+		}
+		if (blocked)
+		{
+			break;
+		}
+
+		pf->dequeuePath();
+		unit->spendTimeUnits(step.cost.time);
+		unit->spendEnergy(step.cost.energy);
+		unit->startWalking(dir, step.pos, _save);
+		while (unit->getStatus() == STATUS_WALKING || unit->getStatus() == STATUS_FLYING)
+		{
+			unit->keepWalking(_save, false);
+		}
+		++_steps;
+
+		measure(BP_LIGHTING, [&]{ te->calculateLighting(LL_UNITS, unit->getPosition(), 2); });
+		measure(BP_FOV, [&]{ te->calculateFOV(unit->getPosition(), 2, false); });
+		if (unit->getUnitsSpottedThisTurn().size() != spotted)
+		{
+			break;
+		}
+		int reactions = 0;
+		measure(BP_REACTION, [&]{ reactions = te->countReactionFireSpotters(unit); });
+		if (reactions > 0)
+		{
+			// the shots are not resolved, but the walk would have been interrupted
+			_reactions += reactions;
+			break;
+		}
+	}
+	pf->abortPath();
+	measure(BP_LIGHTING, [&]{ te->calculateLighting(LL_UNITS, unit->getPosition()); });
+	measure(BP_FOV, [&]{ te->calculateFOV(unit); });
+}
+
+/**
+ * Ends the turn of the current side, like BattlescapeGame::endTurn without the explosions.
+ */
+void BattlescapeBenchmark::endTurn()
+{
+	measure(BP_TURN, [&]
+	{
+		_save->getTileEngine()->closeUfoDoors();
+		_save->endTurn();
+	});
+	measure(BP_LIGHTING, [&]{ _save->getTileEngine()->calculateLighting(LL_FIRE, TileEngine::invalid, 0, true); });
+	measure(BP_FOV, [&]{ _save->getTileEngine()->recalculateFOV(); });
+}
+
+/**
+ * Gets the display name of a phase.
+ * @param phase Phase.
+ * @return Name.
+ */
+const char *BattlescapeBenchmark::getPhaseName(BenchmarkPhase phase)
+{
+	switch (phase)
+	{
+	case BP_AI: return "AI";
+	case BP_PATHFINDING: return "pathfinding";
+	case BP_FOV: return "FOV";
+	case BP_LIGHTING: return "lighting";
+	case BP_REACTION: return "reaction fire";
+	case BP_TURN: return "end of turn";
+	default: return "";
+	}
+}
+
+/**
+ * Writes turns per second, time per phase and peak memory use.
+ * @param out Output stream.
+ */
+void BattlescapeBenchmark::report(std::ostream &out) const
+{
+	double measured = 0.0;
+	for (int i = 0; i < BP_MAX; ++i)
+	{
+		measured += _phaseTime[i];
+	}
+	out << std::fixed << std::setprecision(3);
+	out << "turns: " << _turns << ", AI decisions: " << _decisions << ", steps: " << _steps
+		<< ", attacks: " << _attacks << ", reactions: " << _reactions << "\n";
+	out << "total: " << _totalTime << " s, turns/s: " << (_totalTime > 0.0 ? _turns / _totalTime : 0.0) << "\n";
+	for (int i = 0; i < BP_MAX; ++i)
+	{
+		out << "  " << std::left << std::setw(14) << getPhaseName((BenchmarkPhase)i) << std::right
+			<< std::setw(10) << _phaseTime[i] << " s "
+			<< std::setw(6) << std::setprecision(1) << (_totalTime > 0.0 ? 100.0 * _phaseTime[i] / _totalTime : 0.0) << "%"
+			<< std::setprecision(3) << "\n";
+	}
+	out << "  " << std::left << std::setw(14) << "other" << std::right << std::setw(10) << (_totalTime - measured) << " s\n";
+	out << "peak RSS: " << CrossPlatform::getPeakMemoryUsage() / (1024 * 1024) << " MiB\n";
+}
+
+}
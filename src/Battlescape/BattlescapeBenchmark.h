@@ -0,0 +1,72 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ostream>
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class BattleUnit;
+struct BattleAction;
+
+/**
+ * Plays battlescape turns with the AI controlling every faction,
+ * without any BattlescapeState, Map or video, and measures where the time goes.
+ * Attacks are paid for but not resolved, so the unit population stays stable
+ * and runs on the same save are comparable between builds.
+ */
+class BattlescapeBenchmark
+{
+public:
+	/// Measured parts of a turn.
+	enum BenchmarkPhase { BP_AI, BP_PATHFINDING, BP_FOV, BP_LIGHTING, BP_REACTION, BP_TURN, BP_MAX };
+
+private:
+	SavedBattleGame *_save;
+	double _phaseTime[BP_MAX];
+	double _totalTime;
+	int _turns, _decisions, _steps, _attacks, _reactions;
+
+	/// Runs the AI for all units of the current side.
+	void playSide();
+	/// Runs up to two AI decisions of one unit.
+	void playUnit(BattleUnit *unit);
+	/// Walks a unit along the path to the action target.
+	void walk(BattleUnit *unit, const BattleAction &action);
+	/// Hands the turn over to the next side.
+	void endTurn();
+	/// Calls a function and adds its wall time to a phase.
+	template<typename F>
+	void measure(BenchmarkPhase phase, F &&func);
+
+public:
+	/// Creates a benchmark for a battle with loaded map resources.
+	BattlescapeBenchmark(SavedBattleGame *save);
+	/// Cleans up the benchmark.
+	~BattlescapeBenchmark();
+	/// Plays the given number of full turns.
+	void run(int turns);
+	/// Writes the collected statistics.
+	void report(std::ostream &out) const;
+	/// Gets the display name of a phase.
+	static const char *getPhaseName(BenchmarkPhase phase);
+};
+
+}
@@ -56,6 +56,7 @@
 #include "InfoboxOKState.h"
 #include "UnitFallBState.h"
 #include "../Engine/Logger.h"
+#include "../Engine/FrameProfiler.h"
 #include "../Savegame/BattleUnitStatistics.h"
 #include "ConfirmEndMissionState.h"
 #include "../fmath.h"
@@ -214,7 +215,10 @@ BattlescapeGame::~BattlescapeGame()
  */
 int BattlescapeGame::think()
 {
+	ProfileScope profile(PHASE_BATTLE_GAME);
 	int ret = -1;
+	// lines of sight are only reused within one tick, scripts and stats can change between them
+	getTileEngine()->invalidateVisibility();
 	// nothing is happening - see if we need some alien AI or units panicking or what have you
 	if (_states.empty())
 	{
@@ -336,6 +340,10 @@ void BattlescapeGame::handleAI(BattleUnit *unit)
 		return;
 	}
 
+	if (unit->getVisible())
+	{
+		_save->getPathfinding()->invalidateReachable(); // the player stops knowing about it
+	}
 	unit->setVisible(false); //Possible TODO: check number of player unit observers, then hide the unit if no one can see it. Should then be able to skip the next FOV call.
 
 	_save->getTileEngine()->calculateFOV(unit->getPosition(), 1, false); // might need this populate _visibleUnit for a newly-created alien.
@@ -1140,6 +1148,7 @@ bool BattlescapeGame::playableUnitSelected() const
  */
 void BattlescapeGame::handleState()
 {
+	ProfileScope profile(PHASE_BATTLE_GAME);
 	if (!_states.empty())
 	{
 		// end turn request?
@@ -1955,7 +1964,7 @@ void BattlescapeGame::primaryAction(Position pos)
 				_save->getPathfinding()->removePreview();
 			}
 			_currentAction.target = pos;
-			_save->getPathfinding()->calculate(_currentAction.actor, _currentAction.target, BAM_NORMAL); // precalculate move
+			_save->getPathfinding()->calculateIncremental(_currentAction.actor, _currentAction.target, BAM_NORMAL); // precalculate move
 
 			_currentAction.strafe = false;
 			_currentAction.run = false;
@@ -1980,7 +1989,7 @@ void BattlescapeGame::primaryAction(Position pos)
 			// recalculate path after setting new move types
 			if (BAM_NORMAL != _currentAction.getMoveType())
 			{
-				_save->getPathfinding()->calculate(_currentAction.actor, _currentAction.target, _currentAction.getMoveType());
+				_save->getPathfinding()->calculateIncremental(_currentAction.actor, _currentAction.target, _currentAction.getMoveType());
 			}
 
 			// if running or shifting, ignore spotted enemies (i.e. don't stop)
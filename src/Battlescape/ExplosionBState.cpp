@@ -75,6 +75,34 @@ void ExplosionBState::optValue(int& oldValue, int newValue) const
 	}
 }
 
+/**
+ * Adds the explosion of a tile that is ready to explode to the terrain explosions resolved together.
+ * @param tile Tile that explodes.
+ * @param center Center of the explosion in voxelspace.
+ */
+void ExplosionBState::addTerrainExplosion(Tile *tile, Position center)
+{
+	ItemDamageType DT;
+	switch (tile->getExplosiveType())
+	{
+	case 0:
+		DT = DT_HE;
+		break;
+	case 5:
+		DT = DT_IN;
+		break;
+	case 6:
+		DT = DT_STUN;
+		break;
+	default:
+		DT = DT_SMOKE;
+		break;
+	}
+	int power = tile->getExplosive();
+	tile->setExplosive(0, 0, true);
+	_terrainExplosions.push_back(TileEngine::Explosion{ _attack, center, power, _parent->getMod()->getDamageType(DT), power / 10, true });
+}
+
 /**
  * Initializes the explosion.
  * The animation and sound starts here.
@@ -170,26 +198,20 @@ void ExplosionBState::init()
 	}
 	else if (_tile)
 	{
-		ItemDamageType DT;
-		switch (_tile->getExplosiveType())
+		// every tile ready to explode goes off together with this one, in map order
+		addTerrainExplosion(_tile, _center);
+		SavedBattleGame *save = _parent->getSave();
+		for (int i = 0; i < save->getMapSizeXYZ(); ++i)
 		{
-		case 0:
-			DT = DT_HE;
-			break;
-		case 5:
-			DT = DT_IN;
-			break;
-		case 6:
-			DT = DT_STUN;
-			break;
-		default:
-			DT = DT_SMOKE;
-			break;
+			Tile *tile = save->getTile(i);
+			if (tile != _tile && tile->getExplosive())
+			{
+				addTerrainExplosion(tile, tile->getPosition().toVoxel() + Position(8, 8, 0));
+			}
 		}
-		_power = _tile->getExplosive();
-		_tile->setExplosive(0, 0, true);
-		_damageType = _parent->getMod()->getDamageType(DT);
-		_radius = _power /10;
+		_power = _terrainExplosions.front().power;
+		_damageType = _terrainExplosions.front().type;
+		_radius = _terrainExplosions.front().maxRadius;
 		_areaOfEffect = true;
 	}
 	else
@@ -206,13 +228,30 @@ void ExplosionBState::init()
 	{
 		if (_power > 0)
 		{
-			_parent->getSave()->getTileEngine()->explode(_attack, _center, _power, _damageType, _radius, range);
+			if (_terrainExplosions.empty())
+			{
+				_parent->getSave()->getTileEngine()->explode(_attack, _center, _power, _damageType, _radius, range);
+			}
+			else
+			{
+				_parent->getSave()->getTileEngine()->explodeBatch(_terrainExplosions);
+			}
 
 			int powerForAnimation = _power;
 			if (itemRule && itemRule->getPowerForAnimation() > 0)
 			{
 				powerForAnimation = itemRule->getPowerForAnimation();
 			}
+			std::vector<std::pair<Position, int> > blasts;
+			if (_terrainExplosions.empty())
+			{
+				blasts.push_back(std::make_pair(_center, powerForAnimation));
+			}
+			for (const auto& terrainExplosion : _terrainExplosions)
+			{
+				blasts.push_back(std::make_pair(terrainExplosion.center, terrainExplosion.power));
+				powerForAnimation = std::max(powerForAnimation, terrainExplosion.power);
+			}
 
 			int frame = Mod::EXPLOSION_OFFSET;
 			int frameCount = -1;
@@ -228,22 +267,26 @@ void ExplosionBState::init()
 			{
 				frame -= (frameCount > 0 ? frameCount : Explosion::EXPLODE_FRAMES);
 			}
-			int frameDelay = 0;
-			int counter = std::max(1, (powerForAnimation / 5) / 5);
 			_parent->getMap()->setBlastFlash(true);
-			int lowerLimit = std::max(1, powerForAnimation / 5);
-			for (int i = 0; i < lowerLimit; i++)
+			for (const auto& blast : blasts)
 			{
-				int X = RNG::generate(-powerForAnimation / 2, powerForAnimation / 2);
-				int Y = RNG::generate(-powerForAnimation / 2, powerForAnimation / 2);
-				Position p = _center;
-				p.x += X; p.y += Y;
-				Explosion *explosion = new Explosion(p, frame, frameDelay, true, false, frameCount);
-				// add the explosion on the map
-				_parent->getMap()->getExplosions()->push_back(explosion);
-				if (i > 0 && i % counter == 0)
+				const int blastPower = blast.second;
+				int frameDelay = 0;
+				int counter = std::max(1, (blastPower / 5) / 5);
+				int lowerLimit = std::max(1, blastPower / 5);
+				for (int i = 0; i < lowerLimit; i++)
 				{
-					frameDelay++;
+					int X = RNG::generate(-blastPower / 2, blastPower / 2);
+					int Y = RNG::generate(-blastPower / 2, blastPower / 2);
+					Position p = blast.first;
+					p.x += X; p.y += Y;
+					Explosion *explosion = new Explosion(p, frame, frameDelay, true, false, frameCount);
+					// add the explosion on the map
+					_parent->getMap()->getExplosions()->push_back(explosion);
+					if (i > 0 && i % counter == 0)
+					{
+						frameDelay++;
+					}
 				}
 			}
 			int explosionSpeed = BattlescapeState::DEFAULT_ANIM_SPEED/2;
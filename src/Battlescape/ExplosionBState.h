@@ -19,6 +19,8 @@
  */
 #include "BattleState.h"
 #include "Position.h"
+#include "TileEngine.h"
+#include <vector>
 
 namespace OpenXcom
 {
@@ -47,7 +49,10 @@ private:
 	int _radius;
 	int _range;
 	bool _areaOfEffect, _lowerWeapon, _hit, _psi;
+	std::vector<TileEngine::Explosion> _terrainExplosions;
 
+	/// Adds the explosion of a tile to the terrain explosions.
+	void addTerrainExplosion(Tile *tile, Position center);
 	/// Calculates the effects of the explosion.
 	void explode();
 	/// Set new value to reference if new value is not equal -1.
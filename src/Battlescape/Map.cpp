@@ -36,6 +36,8 @@
 #include "../Engine/Screen.h"
 #include "../Engine/ShaderDraw.h"
 #include "../Engine/ShaderMove.h"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/FrameProfiler.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
 #include "../Savegame/BattleUnit.h"
@@ -52,6 +54,8 @@
 #include "../Interface/NumberText.h"
 #include "../Interface/Text.h"
 #include "../fmath.h"
+#include <cstring>
+#include <cassert>
 
 
 /*
@@ -108,7 +112,7 @@ Map::Map(Game *game, int width, int height, int x, int y, int visibleMapHeight)
 	_game(game), _isTFTD(false), _arrow(0), _anyIndicator(false), _isAltPressed(false), _isCtrlPressed(false),
 	_selectorX(0), _selectorY(0), _mouseX(0), _mouseY(0), _cursorType(CT_NORMAL), _cursorSize(1), _animFrame(0),
 	_projectile(0), _followProjectile(true), _projectileInFOV(false), _explosionInFOV(false), _launch(false), _visibleMapHeight(visibleMapHeight),
-	_unitDying(false), _smoothingEngaged(false), _flashScreen(false), _bgColor(15), _projectileSet(0), _showObstacles(false), _showInfoOnCursor(false)
+	_unitDying(false), _smoothingEngaged(false), _flashScreen(false), _bgColor(15), _projectileSet(0), _terrainCacheValid(false), _terrainCacheState{}, _showObstacles(false), _showInfoOnCursor(false)
 {
 	// TODO: extract to a better place later
 	for (const auto& pair : Options::mods)
@@ -181,6 +185,8 @@ Map::Map(Game *game, int width, int height, int x, int y, int visibleMapHeight)
 	_cacheCursorPosition = TileEngine::invalid;
 	_cacheHasLOS = -1;
 
+	_unitSpriteCache = Options::oxceUnitSpriteCacheSize > 0 ? new UnitSpriteCache(Options::oxceUnitSpriteCacheSize * 1024) : nullptr;
+
 	_nightVisionOn = false;
 	if (Options::oxceToggleNightVisionType == 2)
 	{
@@ -252,6 +258,7 @@ Map::~Map()
 	delete _message;
 	delete _camera;
 	delete _txtAccuracy;
+	delete _unitSpriteCache;
 }
 
 /**
@@ -289,6 +296,7 @@ void Map::init()
 	{
 		_projectileSet = _game->getMod()->getSurfaceSet("UnderwaterProjectiles");
 	}
+	_terrainCacheValid = false;
 }
 
 /**
@@ -311,20 +319,11 @@ void Map::draw()
 	{
 		return;
 	}
+	ProfileScope profile(PHASE_BATTLE_MAP);
 
-	// normally we'd call for a Surface::draw();
-	// but we don't want to clear the background with colour 0, which is transparent (aka black)
-	// we use colour 15 because that actually corresponds to the colour we DO want in all variations of the xcom and tftd palettes.
-	// Note: un-hardcoded the color from 15 to ruleset value, default 15
 	_redraw = false;
-	ShaderDrawFunc(
-		[](Uint8& dest, Uint8 color)
-		{
-			dest = color;
-		},
-		ShaderSurface(this),
-		ShaderScalar<Uint8>(Palette::blockOffset(0) + _bgColor)
-	);
+	_isAltPressed = _game->isAltPressed(true);
+	_isCtrlPressed = _game->isCtrlPressed(true);
 
 	Tile *t;
 
@@ -358,12 +357,577 @@ void Map::draw()
 
 	if ((_save->getSelectedUnit() && _save->getSelectedUnit()->getVisible()) || _unitDying || _save->getSide() == FACTION_PLAYER || _save->getDebugMode() || _projectileInFOV || _explosionInFOV)
 	{
-		drawTerrain(this);
+		drawTerrainCached();
 	}
 	else
 	{
+		clearTerrain(this);
 		_message->blit(this->getSurface());
+		_terrainCacheValid = false;
+	}
+}
+
+/**
+ * Fills the surface with the map background color.
+ * Normally we'd call for a Surface::draw();
+ * but we don't want to clear the background with colour 0, which is transparent (aka black)
+ * we use colour 15 because that actually corresponds to the colour we DO want in all variations of the xcom and tftd palettes.
+ * Note: un-hardcoded the color from 15 to ruleset value, default 15
+ * @param surface The surface to clear.
+ */
+void Map::clearTerrain(Surface *surface)
+{
+	ShaderDrawFunc(
+		[](Uint8& dest, Uint8 color)
+		{
+			dest = color;
+		},
+		ShaderSurface(surface),
+		ShaderScalar<Uint8>(Palette::blockOffset(0) + _bgColor)
+	);
+}
+
+/**
+ * Draws the terrain, reusing the previous frame where nothing changed.
+ * Tiles are compared to the state they had when last drawn, tiles with units, items,
+ * smoke, vapor or the cursor are redrawn every frame, and scrolling moves the old
+ * pixels instead of redrawing them. Everything else falls back to drawing the whole map.
+ */
+void Map::drawTerrainCached()
+{
+	const bool cacheable = Options::oxceMapTerrainCache
+		&& !_projectile && _explosions.empty() && !_unitDying
+		&& !_save->getTileEngine()->getMovingUnit()
+		&& _waypoints.empty() && !_save->getPathfinding()->isPathPreviewed()
+		&& _nvColor == 0 && _debugVisionMode == 0 && _cursorType < CT_AIM
+		&& !_camera->getShowAllLayers() && !_isAltPressed;
+
+	if (!cacheable)
+	{
+		drawTerrainFull();
+		_terrainCacheValid = false;
+		return;
+	}
+
+	const Position cameraPos = _camera->getMapOffset();
+	const BattleUnit *selectedUnit = _save->getSelectedUnit();
+	const std::array<int, 12> state =
+	{{
+		cameraPos.z, getWidth(), getHeight(),
+		_camera->getShowSingleLayer(), _showObstacles, _cursorType, _cursorSize,
+		_save->getBattleState()->getMouseOverIcons(), _save->getSide(), _save->getDebugMode(),
+		selectedUnit ? selectedUnit->getId() : -1, _save->getMapSizeXYZ(),
+	}};
+	const int width = getWidth();
+	const int height = getHeight();
+	const int scrollX = cameraPos.x - _terrainCacheCamera.x;
+	const int scrollY = cameraPos.y - _terrainCacheCamera.y;
+
+	bool full = !_terrainCacheValid || state != _terrainCacheState || std::abs(scrollX) >= width || std::abs(scrollY) >= height;
+	if ((int)_terrainCacheTiles.size() != _save->getMapSizeXYZ())
+	{
+		_terrainCacheTiles.assign(_save->getMapSizeXYZ(), 0);
+		full = true;
+	}
+	_terrainCacheValid = true;
+	_terrainCacheState = state;
+	_terrainCacheCamera = cameraPos;
+
+	const int cellsX = (width + TERRAIN_CACHE_CELL - 1) / TERRAIN_CACHE_CELL;
+	const int cellsY = (height + TERRAIN_CACHE_CELL - 1) / TERRAIN_CACHE_CELL;
+	_terrainCacheCells.assign(cellsX * cellsY, 0);
+	auto markDirty = [&](int x, int y, int w, int h)
+	{
+		if (w <= 0 || h <= 0)
+		{
+			return;
+		}
+		const int beginX = std::max(x, 0) / TERRAIN_CACHE_CELL;
+		const int beginY = std::max(y, 0) / TERRAIN_CACHE_CELL;
+		const int endX = std::min(x + w, width);
+		const int endY = std::min(y + h, height);
+		for (int cy = beginY; cy * TERRAIN_CACHE_CELL < endY; ++cy)
+		{
+			for (int cx = beginX; cx * TERRAIN_CACHE_CELL < endX; ++cx)
+			{
+				_terrainCacheCells[cy * cellsX + cx] = 1;
+			}
+		}
+	};
+
+	if (!full)
+	{
+		if (scrollX || scrollY)
+		{
+			// move what is still on screen and redraw only the uncovered strips
+			Uint8 *pixels = getBuffer();
+			const int pitch = getPitch();
+			const int length = width - std::abs(scrollX);
+			const int srcX = std::max(0, -scrollX);
+			const int destX = std::max(0, scrollX);
+			lock();
+			if (scrollY > 0)
+			{
+				for (int y = height - 1; y >= scrollY; --y)
+				{
+					std::memmove(pixels + y * pitch + destX, pixels + (y - scrollY) * pitch + srcX, length);
+				}
+			}
+			else
+			{
+				for (int y = 0; y < height + scrollY; ++y)
+				{
+					std::memmove(pixels + y * pitch + destX, pixels + (y - scrollY) * pitch + srcX, length);
+				}
+			}
+			unlock();
+			markDirty(scrollX > 0 ? 0 : width + scrollX, 0, std::abs(scrollX), height);
+			markDirty(0, scrollY > 0 ? 0 : height + scrollY, width, std::abs(scrollY));
+		}
+		// things that were animated last frame could have moved away
+		for (const auto& rect : _terrainCacheDynamic)
+		{
+			markDirty(rect.x + scrollX, rect.y + scrollY, rect.w, rect.h);
+		}
+	}
+	_terrainCacheDynamic.clear();
+
+	int beginX, beginY, beginZ, endX, endY, endZ;
+	getTerrainBounds(_camera, width, height, beginX, beginY, beginZ, endX, endY, endZ);
+	Position mapPosition, screenPosition;
+	for (int itZ = beginZ; itZ <= endZ; itZ++)
+	{
+		for (int itY = beginY; itY < endY; itY++)
+		{
+			for (int itX = beginX; itX < endX; itX++)
+			{
+				mapPosition = Position(itX, itY, itZ);
+				_camera->convertMapToScreen(mapPosition, &screenPosition);
+				screenPosition += cameraPos;
+
+				if (screenPosition.x > -_spriteWidth && screenPosition.x < width + _spriteWidth &&
+					screenPosition.y > -_spriteHeight && screenPosition.y < height + _spriteHeight )
+				{
+					Tile *tile = _save->getTile(mapPosition);
+					const int index = tile->getIndex();
+					const uint64_t key = getTerrainCacheKey(tile);
+					const bool dynamic = tile->getUnit() || tile->getSmoke() || tile->getFire()
+						|| !tile->getInventory()->empty()
+						|| (_showObstacles && tile->isObstacle())
+						|| !_vaporParticles[itY * _camera->getMapSizeX() + itX].empty()
+						|| (_cursorType != CT_NONE && _selectorX > itX - _cursorSize && _selectorY > itY - _cursorSize && _selectorX < itX+1 && _selectorY < itY+1);
+
+					// area the sprites of this tile or its unit can cover, including the unit arrow
+					SDL_Rect rect;
+					rect.x = screenPosition.x - _spriteWidth / 2;
+					rect.y = screenPosition.y - 2 * _spriteHeight;
+					rect.w = 2 * _spriteWidth;
+					rect.h = 3 * _spriteHeight + 8;
+					if (dynamic)
+					{
+						_terrainCacheDynamic.push_back(rect);
+					}
+					if (!full && (dynamic || key != _terrainCacheTiles[index]))
+					{
+						markDirty(rect.x, rect.y, rect.w, rect.h);
+					}
+					_terrainCacheTiles[index] = key;
+				}
+			}
+		}
+	}
+
+	if (full)
+	{
+		drawTerrainFull();
+		return;
+	}
+
+	// join dirty cells into rectangles: runs in each row, extended down while the next row has the same run
+	std::vector<SDL_Rect> rects;
+	for (int cy = 0; cy < cellsY; ++cy)
+	{
+		for (int cx = 0; cx < cellsX; ++cx)
+		{
+			if (!_terrainCacheCells[cy * cellsX + cx])
+			{
+				continue;
+			}
+			int runEnd = cx;
+			while (runEnd < cellsX && _terrainCacheCells[cy * cellsX + runEnd])
+			{
+				++runEnd;
+			}
+			int rowEnd = cy + 1;
+			while (rowEnd < cellsY)
+			{
+				Uint8 *row = &_terrainCacheCells[rowEnd * cellsX];
+				if (std::find(row + cx, row + runEnd, 0) != row + runEnd)
+				{
+					break;
+				}
+				std::fill(row + cx, row + runEnd, 0);
+				++rowEnd;
+			}
+			SDL_Rect rect;
+			rect.x = cx * TERRAIN_CACHE_CELL;
+			rect.y = cy * TERRAIN_CACHE_CELL;
+			rect.w = std::min(runEnd * TERRAIN_CACHE_CELL, width) - rect.x;
+			rect.h = std::min(rowEnd * TERRAIN_CACHE_CELL, height) - rect.y;
+			rects.push_back(rect);
+			cx = runEnd;
+		}
+	}
+
+	// each part is drawn with a margin, past some point redrawing everything is cheaper
+	int area = 0;
+	for (const auto& rect : rects)
+	{
+		area += (rect.w + 2 * _spriteWidth) * (rect.h + 2 * _spriteHeight);
+	}
+	if (area >= width * height)
+	{
+		drawTerrainFull();
+		return;
+	}
+
+	drawTerrainParts(rects);
+}
+
+/**
+ * Gets the area of the map surface drawn for a part of the map:
+ * the part with a margin of one sprite around it, clipped to the map surface.
+ * @param rect Part of the map surface.
+ * @param spriteWidth Width of a tile sprite.
+ * @param spriteHeight Height of a tile sprite.
+ * @param width Width of the map surface.
+ * @param height Height of the map surface.
+ * @return Area to draw.
+ */
+static SDL_Rect getTerrainPartArea(const SDL_Rect &rect, int spriteWidth, int spriteHeight, int width, int height)
+{
+	SDL_Rect area;
+	area.x = std::max(rect.x - spriteWidth, 0);
+	area.y = std::max(rect.y - spriteHeight, 0);
+	area.w = std::min(rect.x + rect.w + spriteWidth, width) - area.x;
+	area.h = std::min(rect.y + rect.h + spriteHeight, height) - area.y;
+	return area;
+}
+
+/**
+ * Copies a drawn part of the map back to the map surface, without its margin.
+ * @param dest Buffer of the map surface.
+ * @param destPitch Pitch of the map surface.
+ * @param rect Part of the map surface to copy.
+ * @param src Buffer the part was drawn in.
+ * @param srcPitch Pitch of the part buffer.
+ * @param area Area of the map surface the part buffer covers.
+ */
+static void copyTerrainPart(Uint8 *dest, int destPitch, const SDL_Rect &rect, const Uint8 *src, int srcPitch, const SDL_Rect &area)
+{
+	const int offsetX = rect.x - area.x;
+	const int offsetY = rect.y - area.y;
+	for (int y = 0; y < rect.h; ++y)
+	{
+		std::memcpy(dest + (rect.y + y) * destPitch + rect.x, src + (offsetY + y) * srcPitch + offsetX, rect.w);
+	}
+}
+
+#ifndef NDEBUG
+
+static auto dummyTerrainParts = ([]
+{
+	// a small map of overlapping tile sprites, culled the same way as in Map::drawTerrain
+	// and some of them drawn lower than the position the culling checks,
+	// must look the same drawn at once and drawn in parts with margins
+	const int spriteWidth = 32, spriteHeight = 40;
+	const int width = 320, height = 200, pitch = width + 4;
+	const int mapSize = 12;
+
+	auto drawMap = [&](Uint8 *buffer, int bufferPitch, int bufferWidth, int bufferHeight, int offsetX, int offsetY)
+	{
+		for (int y = 0; y < bufferHeight; ++y)
+		{
+			std::memset(buffer + y * bufferPitch, 0, bufferWidth);
+		}
+		for (int itY = 0; itY < mapSize; ++itY)
+		{
+			for (int itX = 0; itX < mapSize; ++itX)
+			{
+				const int screenX = offsetX + (itX - itY) * (spriteWidth / 2);
+				const int screenY = offsetY + (itX + itY) * (spriteHeight / 5);
+				const int drop = (itX * 7 + itY * 3) % (spriteHeight / 2);
+				if (!(screenX > -spriteWidth && screenX < bufferWidth + spriteWidth &&
+					screenY > -spriteHeight && screenY < bufferHeight + spriteHeight))
+				{
+					continue;
+				}
+				for (int sy = 0; sy < spriteHeight; ++sy)
+				{
+					for (int sx = 0; sx < spriteWidth; ++sx)
+					{
+						const int px = screenX + sx, py = screenY + drop + sy;
+						const Uint8 color = (sx + sy + itX * 3 + itY * 5) % 4 ? (Uint8)(1 + itX + itY * mapSize) : 0;
+						if (color && px >= 0 && px < bufferWidth && py >= 0 && py < bufferHeight)
+						{
+							buffer[py * bufferPitch + px] = color;
+						}
+					}
+				}
+			}
+		}
+	};
+	auto drawParts = [&](Uint8 *buffer, const std::vector<SDL_Rect> &rects)
+	{
+		for (const auto &rect : rects)
+		{
+			const SDL_Rect area = getTerrainPartArea(rect, spriteWidth, spriteHeight, width, height);
+			std::vector<Uint8> part(area.w * area.h);
+			drawMap(part.data(), area.w, area.w, area.h, width / 2 - area.x, -20 - area.y);
+			copyTerrainPart(buffer, pitch, rect, part.data(), area.w, area);
+		}
+	};
+	auto makeRect = [](int x, int y, int w, int h)
+	{
+		SDL_Rect rect;
+		rect.x = x;
+		rect.y = y;
+		rect.w = w;
+		rect.h = h;
+		return rect;
+	};
+
+	std::vector<Uint8> whole(pitch * height);
+	drawMap(whole.data(), pitch, width, height, width / 2, -20);
+
+	std::vector<Uint8> bands(whole.size());
+	drawParts(bands.data(), { makeRect(0, 0, width, 67), makeRect(0, 67, width, 66), makeRect(0, 133, width, 67) });
+	assert(bands == whole);
+
+	std::vector<Uint8> dirty(whole);
+	for (int y = 0; y < height; ++y)
+	{
+		std::memset(dirty.data() + y * pitch + 40, 0xFF, 100);
+		std::memset(dirty.data() + y * pitch + 200, 0xFF, 30);
+	}
+	drawParts(dirty.data(), { makeRect(40, 0, 100, 90), makeRect(40, 90, 100, 110), makeRect(200, 0, 30, height) });
+	assert(dirty == whole);
+
+	return 0;
+})();
+
+#endif
+
+/**
+ * Draws the whole map. When the worker threads can be used,
+ * the map is split in horizontal bands that are drawn at the same time.
+ */
+void Map::drawTerrainFull()
+{
+	if (!canDrawTerrainThreaded())
+	{
+		clearTerrain(this);
+		drawTerrain(this, _camera);
+		return;
+	}
+
+	const int count = ThreadPool::getThreadCount();
+	std::vector<SDL_Rect> bands;
+	for (int i = 0; i < count; ++i)
+	{
+		SDL_Rect band;
+		band.x = 0;
+		band.y = getHeight() * i / count;
+		band.w = getWidth();
+		band.h = getHeight() * (i + 1) / count - band.y;
+		if (band.h > 0)
+		{
+			bands.push_back(band);
+		}
+	}
+	drawTerrainParts(bands);
+}
+
+/**
+ * Redraws parts of the map, each one in its own surface, in the same order as the whole map would be drawn.
+ * Every part is drawn with a margin of one sprite around it (up to the edge of the map surface),
+ * so tiles skipped at the edges of the drawn area can't leave holes in what is copied back,
+ * and the result is the same as drawing the whole map at once. Debug builds check this
+ * on every call against the whole map drawn on the main thread.
+ * @param rects Areas of the map surface to redraw, must not overlap.
+ */
+void Map::drawTerrainParts(const std::vector<SDL_Rect> &rects)
+{
+	const int count = (int)rects.size();
+	std::vector<SDL_Rect> areas(count);
+	if ((int)_terrainParts.size() < count)
+	{
+		_terrainParts.resize(count);
+	}
+	for (int i = 0; i < count; ++i)
+	{
+		const SDL_Rect &rect = rects[i];
+		const SDL_Rect &area = areas[i] = getTerrainPartArea(rect, _spriteWidth, _spriteHeight, getWidth(), getHeight());
+
+		// surfaces are created here, as SDL can't be trusted to do it from other threads
+		auto &part = _terrainParts[i];
+		if (!part || part->getWidth() != area.w || part->getHeight() != area.h)
+		{
+			part = std::make_unique<Surface>(area.w, area.h);
+		}
+	}
+
+	const Position cameraPos = _camera->getMapOffset();
+	auto drawPart = [&](Surface *part, const SDL_Rect &area)
+	{
+		Camera camera = *_camera;
+		camera.setMapOffset(cameraPos - Position(area.x, area.y, 0));
+		clearTerrain(part);
+		drawTerrain(part, &camera);
+	};
+
+	const bool threaded = count > 1 && canDrawTerrainThreaded();
+	if (threaded)
+	{
+		loadTerrainSprites();
+		ThreadPool::parallelFor(count, [&](int i)
+		{
+			drawPart(_terrainParts[i].get(), areas[i]);
+		});
+	}
+	else
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			drawPart(_terrainParts[i].get(), areas[i]);
+		}
+	}
+
+	lock();
+	for (int i = 0; i < count; ++i)
+	{
+		const Surface *part = _terrainParts[i].get();
+		copyTerrainPart(getBuffer(), getPitch(), rects[i], part->getBuffer(), part->getPitch(), areas[i]);
+	}
+	unlock();
+
+#ifndef NDEBUG
+	// the parts must look exactly like the whole map drawn at once on this thread,
+	// anything reaching past the margin or not safe to draw on the worker threads shows up here
+	Surface check(getWidth(), getHeight());
+	clearTerrain(&check);
+	drawTerrain(&check, _camera);
+	for (const auto& rect : rects)
+	{
+		for (int y = rect.y; y < rect.y + rect.h; ++y)
+		{
+			assert(std::memcmp(getBuffer() + y * getPitch() + rect.x, check.getBuffer() + y * check.getPitch() + rect.x, rect.w) == 0 && "map drawn in parts differs from the whole map");
+		}
+	}
+#endif
+}
+
+/**
+ * Checks if the map can be drawn by the worker threads this frame.
+ * A flying projectile moves the camera while drawing and the explosion
+ * flash changes the whole screen, so those frames are drawn on the main thread.
+ * @return True if the parts of the map can be drawn in parallel.
+ */
+bool Map::canDrawTerrainThreaded() const
+{
+	return Options::oxceMapDrawThreads && ThreadPool::getThreadCount() > 1
+		&& !_projectile && !(_explosionInFOV && _flashScreen);
+}
+
+/**
+ * Makes sure every sprite set used to draw the map is loaded,
+ * lazy loading them from the worker threads would not be safe.
+ */
+void Map::loadTerrainSprites()
+{
+	if (!Options::lazyLoadResources)
+	{
+		return;
+	}
+	for (const char *name : { "CURSOR.PCK", "SMOKE.PCK", "HANDOB.PCK", "BREATH-1.PCK", "DETBLOB.DAT", "FLOOROB.PCK", "Pathfinding", "X1.PCK", "HIT.PCK" })
+	{
+		_game->getMod()->getSurfaceSet(name, false);
+	}
+	for (const auto* unit : *_save->getUnits())
+	{
+		_game->getMod()->getSurfaceSet(unit->getArmor()->getSpriteSheet(), false);
+	}
+}
+
+/**
+ * Gets the range of tiles that can be seen on a surface of given size.
+ * @param camera Camera used to draw the surface.
+ * @param width Width of the surface.
+ * @param height Height of the surface.
+ * @param beginX, beginY, beginZ First tile to draw.
+ * @param endX, endY End of the tile range, the Z end is included.
+ */
+void Map::getTerrainBounds(const Camera *camera, int width, int height, int &beginX, int &beginY, int &beginZ, int &endX, int &endY, int &endZ) const
+{
+	int dummy;
+	beginZ = 0;
+	endZ = _save->getMapSizeZ() - 1;
+
+	// get corner map coordinates to give rough boundaries in which tiles to redraw are,
+	// the corners are the ones of the area where tiles are drawn, so that the same tiles are drawn
+	// whether the map is drawn at once or in parts
+	camera->convertScreenToMap(-_spriteWidth, -_spriteHeight, &beginX, &dummy);
+	camera->convertScreenToMap(width + _spriteWidth, -_spriteHeight, &dummy, &beginY);
+	camera->convertScreenToMap(width + _spriteWidth, height + _spriteHeight, &endX, &dummy);
+	camera->convertScreenToMap(-_spriteWidth, height + _spriteHeight, &dummy, &endY);
+	beginY -= (camera->getViewLevel() * 2);
+	beginX -= (camera->getViewLevel() * 2);
+	if (beginX < 0)
+		beginX = 0;
+	if (beginY < 0)
+		beginY = 0;
+
+	if (!camera->getShowAllLayers())
+	{
+		endZ = std::min(endZ, camera->getViewLevel());
+	}
+	else if (endZ > camera->getViewLevel())
+	{
+		// layers above the camera are drawn higher on the screen
+		endX = std::min(endX + (endZ - camera->getViewLevel()) * 2, _save->getMapSizeX());
+		endY = std::min(endY + (endZ - camera->getViewLevel()) * 2, _save->getMapSizeY());
+	}
+	if (camera->getShowSingleLayer())
+	{
+		beginZ = camera->getViewLevel();
+		endZ = camera->getViewLevel();
+	}
+}
+
+/**
+ * Gets a value that changes whenever the static part of a tile would be drawn differently.
+ * @param tile The tile.
+ * @return Hash of everything drawTerrain reads from the tile.
+ */
+uint64_t Map::getTerrainCacheKey(Tile *tile)
+{
+	uint64_t key = 0;
+	auto add = [&key](uint64_t value)
+	{
+		key = (key ^ value) * 0x9E3779B97F4A7C15ULL;
+		key ^= key >> 29;
+	};
+	for (int part = O_FLOOR; part < O_MAX; ++part)
+	{
+		add((uintptr_t)tile->getSprite((TilePart)part).getBuffer());
+		add(tile->getYOffset((TilePart)part));
+		add(tile->getObstacle(part) | (tile->isDiscovered((TilePart)part) << 1));
 	}
+	add(tile->isDiscovered(O_FLOOR) ? reShade(tile) : 16);
+	add(getWallShade(O_WESTWALL, tile));
+	add(getWallShade(O_NORTHWALL, tile));
+	add(tile->isBackTileObject(O_OBJECT));
+	return key;
 }
 
 void Map::refreshAIProgress(int progress)
@@ -486,7 +1050,7 @@ int getShadePulseForFrame(int shade, int frame)
  * @param obstacleShade
  * @param topLayer
  */
-void Map::drawUnit(UnitSprite &unitSprite, Tile *unitTile, Tile *currTile, Position currTileScreenPosition, bool topLayer, BattleUnit* movingUnit)
+void Map::drawUnit(UnitSprite &unitSprite, const Camera *camera, Tile *unitTile, Tile *currTile, Position currTileScreenPosition, bool topLayer, BattleUnit* movingUnit)
 {
 	const int tileFoorWidth = 32;
 	const int tileFoorHeight = 16;
@@ -676,8 +1240,8 @@ void Map::drawUnit(UnitSprite &unitSprite, Tile *unitTile, Tile *currTile, Posit
 	}
 
 	Position tileScreenPosition;
-	_camera->convertMapToScreen(unitTile->getPosition() + Position(0,0, (-unitFromBelow) + (+unitFromAbove)), &tileScreenPosition);
-	tileScreenPosition += _camera->getMapOffset();
+	camera->convertMapToScreen(unitTile->getPosition() + Position(0,0, (-unitFromBelow) + (+unitFromAbove)), &tileScreenPosition);
+	tileScreenPosition += camera->getMapOffset();
 
 	//get shade helpers
 	auto getTileShade = [&](Tile* tile)
@@ -734,23 +1298,20 @@ void Map::drawUnit(UnitSprite &unitSprite, Tile *unitTile, Tile *currTile, Posit
  * Keep this function as optimised as possible. It's big to minimise overhead of function calls.
  * @param surface The surface to draw on.
  */
-void Map::drawTerrain(Surface *surface)
+void Map::drawTerrain(Surface *surface, Camera *camera)
 {
-	_isAltPressed = _game->isAltPressed(true);
-	_isCtrlPressed = _game->isCtrlPressed(true);
 	int frameNumber = 0;
 	SurfaceRaw<const Uint8> tmpSurface;
 	Tile *tile;
-	int beginX = 0, endX = _save->getMapSizeX() - 1;
-	int beginY = 0, endY = _save->getMapSizeY() - 1;
-	int beginZ = 0, endZ = _save->getMapSizeZ() - 1;
+	int beginX, endX;
+	int beginY, endY;
+	int beginZ, endZ;
 	Position mapPosition, screenPosition, bulletPositionScreen, movingUnitPosition;
 	int bulletLowX=16000, bulletLowY=16000, bulletLowZ=16000, bulletHighX=0, bulletHighY=0, bulletHighZ=0;
-	int dummy;
 	BattleUnit *movingUnit = _save->getTileEngine()->getMovingUnit();
 	int tileShade, tileColor, obstacleShade;
 	UnitSprite unitSprite(surface, _game->getMod(), _save, _animFrame, _save->getDepth() != 0,
-		_isTFTD ? ArrowColorsTFTD[1] : ArrowColorsUFO[1], _isTFTD ? ArrowColorsTFTD[2] : ArrowColorsUFO[2]);
+		_isTFTD ? ArrowColorsTFTD[1] : ArrowColorsUFO[1], _isTFTD ? ArrowColorsTFTD[2] : ArrowColorsUFO[2], _unitSpriteCache);
 	ItemSprite itemSprite(surface, _game->getMod(), _save, _animFrame);
 
 	const int halfAnimFrame = (_animFrame / 2) % 4;
@@ -786,18 +1347,18 @@ void Map::drawTerrain(Surface *surface)
 		bulletHighZ = bulletHighZ / 24;
 
 		// if the projectile is outside the viewport - center it back on it
-		_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+		camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
 
 		if (_projectileInFOV && _followProjectile)
 		{
-			Position newCam = _camera->getMapOffset();
+			Position newCam = camera->getMapOffset();
 			if (newCam.z != bulletHighZ) //switch level
 			{
 				newCam.z = bulletHighZ;
 				if (_projectileInFOV)
 				{
-					_camera->setMapOffset(newCam);
-					_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+					camera->setMapOffset(newCam);
+					camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
 				}
 			}
 			if (_smoothCamera)
@@ -808,8 +1369,8 @@ void Map::drawTerrain(Surface *surface)
 					if ((bulletPositionScreen.x < 1 || bulletPositionScreen.x > surface->getWidth() - 1 ||
 						bulletPositionScreen.y < 1 || bulletPositionScreen.y > _visibleMapHeight - 1))
 					{
-						_camera->centerOnPosition(Position(bulletLowX, bulletLowY, bulletHighZ), false);
-						_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+						camera->centerOnPosition(Position(bulletLowX, bulletLowY, bulletHighZ), false);
+						camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
 					}
 				}
 				if (!_smoothingEngaged)
@@ -822,7 +1383,7 @@ void Map::drawTerrain(Surface *surface)
 				}
 				else
 				{
-					_camera->jumpXY(surface->getWidth() / 2 - bulletPositionScreen.x, _visibleMapHeight / 2 - bulletPositionScreen.y);
+					camera->jumpXY(surface->getWidth() / 2 - bulletPositionScreen.x, _visibleMapHeight / 2 - bulletPositionScreen.y);
 				}
 			}
 			else
@@ -833,52 +1394,32 @@ void Map::drawTerrain(Surface *surface)
 					enough = true;
 					if (bulletPositionScreen.x < 0)
 					{
-						_camera->jumpXY(+surface->getWidth(), 0);
+						camera->jumpXY(+surface->getWidth(), 0);
 						enough = false;
 					}
 					else if (bulletPositionScreen.x > surface->getWidth())
 					{
-						_camera->jumpXY(-surface->getWidth(), 0);
+						camera->jumpXY(-surface->getWidth(), 0);
 						enough = false;
 					}
 					else if (bulletPositionScreen.y < 0)
 					{
-						_camera->jumpXY(0, +_visibleMapHeight);
+						camera->jumpXY(0, +_visibleMapHeight);
 						enough = false;
 					}
 					else if (bulletPositionScreen.y > _visibleMapHeight)
 					{
-						_camera->jumpXY(0, -_visibleMapHeight);
+						camera->jumpXY(0, -_visibleMapHeight);
 						enough = false;
 					}
-					_camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
+					camera->convertVoxelToScreen(_projectile->getPosition(), &bulletPositionScreen);
 				}
 				while (!enough);
 			}
 		}
 	}
 
-	// get corner map coordinates to give rough boundaries in which tiles to redraw are
-	_camera->convertScreenToMap(0, 0, &beginX, &dummy);
-	_camera->convertScreenToMap(surface->getWidth(), 0, &dummy, &beginY);
-	_camera->convertScreenToMap(surface->getWidth() + _spriteWidth, surface->getHeight() + _spriteHeight, &endX, &dummy);
-	_camera->convertScreenToMap(0, surface->getHeight() + _spriteHeight, &dummy, &endY);
-	beginY -= (_camera->getViewLevel() * 2);
-	beginX -= (_camera->getViewLevel() * 2);
-	if (beginX < 0)
-		beginX = 0;
-	if (beginY < 0)
-		beginY = 0;
-
-	if (!_camera->getShowAllLayers())
-	{
-		endZ = std::min(endZ, _camera->getViewLevel());
-	}
-	if (_camera->getShowSingleLayer())
-	{
-		beginZ = _camera->getViewLevel();
-		endZ = _camera->getViewLevel();
-	}
+	getTerrainBounds(camera, surface->getWidth(), surface->getHeight(), beginX, beginY, beginZ, endX, endY, endZ);
 
 
 	bool pathfinderTurnedOn = _save->getPathfinding()->isPathPreviewed();
@@ -896,7 +1437,7 @@ void Map::drawTerrain(Surface *surface)
 	}
 
 	surface->lock();
-	const Position cameraPos = _camera->getMapOffset();
+	const Position cameraPos = camera->getMapOffset();
 	for (int itZ = beginZ; itZ <= endZ; itZ++)
 	{
 		bool topLayer = itZ == endZ;
@@ -906,7 +1447,7 @@ void Map::drawTerrain(Surface *surface)
 			tile = _save->getTile(mapPosition);
 			for (int itX = beginX; itX < endX; itX++, mapPosition.x++, tile++)
 			{
-				_camera->convertMapToScreen(mapPosition, &screenPosition);
+				camera->convertMapToScreen(mapPosition, &screenPosition);
 				screenPosition += cameraPos;
 
 				// only render cells that are inside the surface
@@ -950,7 +1491,7 @@ void Map::drawTerrain(Surface *surface)
 					// Draw cursor back
 					if (_cursorType != CT_NONE && _selectorX > itX - _cursorSize && _selectorY > itY - _cursorSize && _selectorX < itX+1 && _selectorY < itY+1 && !_save->getBattleState()->getMouseOverIcons())
 					{
-						if (_camera->getViewLevel() == itZ)
+						if (camera->getViewLevel() == itZ)
 						{
 							if (_cursorType != CT_AIM)
 							{
@@ -969,7 +1510,7 @@ void Map::drawTerrain(Surface *surface)
 							tmpSurface = _game->getMod()->getSurfaceSet("CURSOR.PCK")->getFrame(frameNumber);
 							Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y, 0);
 						}
-						else if (_camera->getViewLevel() > itZ)
+						else if (camera->getViewLevel() > itZ)
 						{
 							frameNumber = 2; // blue box
 							tmpSurface = _game->getMod()->getSurfaceSet("CURSOR.PCK")->getFrame(frameNumber);
@@ -989,7 +1530,7 @@ void Map::drawTerrain(Surface *surface)
 
 						for (size_t b = 0; b < std::size(backPos); ++b)
 						{
-							drawUnit(unitSprite, _save->getTile(mapPosition + backPos[b]), tile, screenPosition, topLayer);
+							drawUnit(unitSprite, camera, _save->getTile(mapPosition + backPos[b]), tile, screenPosition, topLayer);
 						}
 					}
 
@@ -1091,7 +1632,7 @@ void Map::drawTerrain(Surface *surface)
 								voxelPos.z / 24 == itZ &&
 								_save->getTileEngine()->isVoxelVisible(voxelPos))
 							{
-								_camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
+								camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
 
 								itemSprite.drawShadow(item,
 									bulletPositionScreen.x - 16,
@@ -1108,7 +1649,7 @@ void Map::drawTerrain(Surface *surface)
 								voxelPos.z / 24 == itZ &&
 								_save->getTileEngine()->isVoxelVisible(voxelPos))
 							{
-								_camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
+								camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
 
 								itemSprite.draw(item,
 									bulletPositionScreen.x - 16,
@@ -1145,7 +1686,7 @@ void Map::drawTerrain(Surface *surface)
 											voxelPos.z / 24 == itZ &&
 											_save->getTileEngine()->isVoxelVisible(voxelPos))
 										{
-											_camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
+											camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
 											bulletPositionScreen.x -= tmpSurface.getWidth() / 2;
 											bulletPositionScreen.y -= tmpSurface.getHeight() / 2;
 											Surface::blitRaw(surface, tmpSurface, bulletPositionScreen.x, bulletPositionScreen.y, 16, false, _nvColor);
@@ -1158,7 +1699,7 @@ void Map::drawTerrain(Surface *surface)
 											voxelPos.z / 24 == itZ &&
 											_save->getTileEngine()->isVoxelVisible(voxelPos))
 										{
-											_camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
+											camera->convertVoxelToScreen(voxelPos, &bulletPositionScreen);
 											bulletPositionScreen.x -= tmpSurface.getWidth() / 2;
 											bulletPositionScreen.y -= tmpSurface.getHeight() / 2;
 											Surface::blitRaw(surface, tmpSurface, bulletPositionScreen.x, bulletPositionScreen.y, 0, false, _nvColor);
@@ -1193,14 +1734,14 @@ void Map::drawTerrain(Surface *surface)
 									dest = transparetOffsets[dest];
 								}
 							},
-							ShaderSurface(this),
+							ShaderSurface(surface),
 							ShaderMove(pixelMask, vaporX, vaporY)
 						);
 					}
 
 					unit = tile->getUnit();
 					// Draw soldier from this tile, below or above
-					drawUnit(unitSprite, tile, tile, screenPosition, topLayer, isUnitMovingNearby ? movingUnit : nullptr);
+					drawUnit(unitSprite, camera, tile, tile, screenPosition, topLayer, isUnitMovingNearby ? movingUnit : nullptr);
 
 					if (isUnitMovingNearby)
 					{
@@ -1216,7 +1757,7 @@ void Map::drawTerrain(Surface *surface)
 
 						for (size_t f = 0; f < std::size(frontPos); ++f)
 						{
-							drawUnit(unitSprite, _save->getTile(mapPosition + frontPos[f]), tile, screenPosition, topLayer);
+							drawUnit(unitSprite, camera, _save->getTile(mapPosition + frontPos[f]), tile, screenPosition, topLayer);
 						}
 					}
 
@@ -1268,7 +1809,7 @@ void Map::drawTerrain(Surface *surface)
 									dest = transparetOffsets[dest];
 								}
 							},
-							ShaderSurface(this),
+							ShaderSurface(surface),
 							ShaderMove(pixelMask, vaporX, vaporY)
 						);
 					}
@@ -1308,7 +1849,9 @@ void Map::drawTerrain(Surface *surface)
 					// Draw cursor front
 					if (_cursorType != CT_NONE && _selectorX > itX - _cursorSize && _selectorY > itY - _cursorSize && _selectorX < itX+1 && _selectorY < itY+1 && !_save->getBattleState()->getMouseOverIcons())
 					{
-						if (_camera->getViewLevel() == itZ)
+						// the accuracy text and its caches are shared by every part of the map being drawn
+						std::lock_guard<std::mutex> cursorLock(_cursorInfoMutex);
+						if (camera->getViewLevel() == itZ)
 						{
 							if (_cursorType != CT_AIM)
 							{
@@ -1520,13 +2063,13 @@ void Map::drawTerrain(Surface *surface)
 								_txtAccuracy->blitNShade(surface, screenPosition.x, screenPosition.y, 0);
 							}
 						}
-						else if (_camera->getViewLevel() > itZ)
+						else if (camera->getViewLevel() > itZ)
 						{
 							frameNumber = 5; // blue box
 							tmpSurface = _game->getMod()->getSurfaceSet("CURSOR.PCK")->getFrame(frameNumber);
 							Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y, 0);
 						}
-						if (!_isAltPressed && _cursorType > CT_AIM && _camera->getViewLevel() == itZ)
+						if (!_isAltPressed && _cursorType > CT_AIM && camera->getViewLevel() == itZ)
 						{
 							bool ignore = false;
 							if (_cursorType == CT_PSI || _cursorType == CT_WAYPOINT)
@@ -1599,8 +2142,8 @@ void Map::drawTerrain(Surface *surface)
 				for (int itY = beginY; itY <= endY; itY++)
 				{
 					mapPosition = Position(itX, itY, itZ);
-					_camera->convertMapToScreen(mapPosition, &screenPosition);
-					screenPosition += _camera->getMapOffset();
+					camera->convertMapToScreen(mapPosition, &screenPosition);
+					screenPosition += camera->getMapOffset();
 
 					// only render cells that are inside the surface
 					if (screenPosition.x > -_spriteWidth && screenPosition.x < surface->getWidth() + _spriteWidth &&
@@ -1683,10 +2226,10 @@ void Map::drawTerrain(Surface *surface)
 	}
 
 	auto* selectedUnit = _save->getSelectedUnit();
-	if (selectedUnit && (_save->getSide() == FACTION_PLAYER || _save->getDebugMode()) && selectedUnit->getPosition().z <= _camera->getViewLevel())
+	if (selectedUnit && (_save->getSide() == FACTION_PLAYER || _save->getDebugMode()) && selectedUnit->getPosition().z <= camera->getViewLevel())
 	{
-		_camera->convertMapToScreen(selectedUnit->getPosition(), &screenPosition);
-		screenPosition += _camera->getMapOffset();
+		camera->convertMapToScreen(selectedUnit->getPosition(), &screenPosition);
+		screenPosition += camera->getMapOffset();
 		Position offset = calculateWalkingOffset(selectedUnit).ScreenOffset;
 		if (selectedUnit->isBigUnit())
 		{
@@ -1713,9 +2256,9 @@ void Map::drawTerrain(Surface *surface)
 			if (motionScan || customMarker)
 			{
 				Position temp = myUnit->getPosition();
-				temp.z = _camera->getViewLevel();
-				_camera->convertMapToScreen(temp, &screenPosition);
-				screenPosition += _camera->getMapOffset();
+				temp.z = camera->getViewLevel();
+				camera->convertMapToScreen(temp, &screenPosition);
+				screenPosition += camera->getMapOffset();
 				Position offset;
 				//calculateWalkingOffset(myUnit, &offset);
 				if (myUnit->isBigUnit())
@@ -1763,10 +2306,10 @@ void Map::drawTerrain(Surface *surface)
 	{
 		for (auto& pos : _save->getCraftTiles())
 		{
-			if (pos.z == _camera->getViewLevel())
+			if (pos.z == camera->getViewLevel())
 			{
-				_camera->convertMapToScreen(pos, &screenPosition);
-				screenPosition += _camera->getMapOffset();
+				camera->convertMapToScreen(pos, &screenPosition);
+				screenPosition += camera->getMapOffset();
 				screenPosition.y += 2; // based on vanilla soldier standHeight
 				_arrow->blitNShade(
 					surface,
@@ -1799,7 +2342,7 @@ void Map::drawTerrain(Surface *surface)
 		{
 			for (const auto* explosion : _explosions)
 			{
-				_camera->convertVoxelToScreen(explosion->getPosition(), &bulletPositionScreen);
+				camera->convertVoxelToScreen(explosion->getPosition(), &bulletPositionScreen);
 				if (explosion->isBig())
 				{
 					if (explosion->getCurrentFrame() >= 0)
@@ -2008,6 +2551,10 @@ void Map::animate(bool redraw)
 {
 	_save->nextAnimFrame();
 	_animFrame = _save->getAnimFrame();
+	if (_unitSpriteCache)
+	{
+		_unitSpriteCache->clearRecolors();
+	}
 
 	// random ambient sounds
 	{
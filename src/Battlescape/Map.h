@@ -24,6 +24,10 @@
 #include "Position.h"
 #include "Particle.h"
 #include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <cstdint>
 
 namespace OpenXcom
 {
@@ -40,6 +44,7 @@ class Timer;
 class Text;
 class Tile;
 class UnitSprite;
+class UnitSpriteCache;
 
 enum CursorType { CT_NONE, CT_NORMAL, CT_AIM, CT_PSI, CT_WAYPOINT, CT_THROW };
 enum TilePart : int;
@@ -65,6 +70,7 @@ private:
 	static const int NIGHT_VISION_SHADE = 4;
 	static const int NIGHT_VISION_MAX_SHADE = 8;
 	static const int BULLET_SPRITES = 35;
+	static const int TERRAIN_CACHE_CELL = 32;
 	Timer *_scrollMouseTimer, *_scrollKeyTimer, *_obstacleTimer;
 	Timer *_fadeTimer;
 	int _fadeShade;
@@ -103,9 +109,26 @@ private:
 	bool _previewSettingArrows, _previewSettingTu, _previewSettingEnergy;
 	Text *_txtAccuracy;
 	SurfaceSet *_projectileSet;
+	bool _terrainCacheValid;
+	Position _terrainCacheCamera;
+	std::array<int, 12> _terrainCacheState;
+	std::vector<uint64_t> _terrainCacheTiles;
+	std::vector<SDL_Rect> _terrainCacheDynamic;
+	std::vector<Uint8> _terrainCacheCells;
+	std::vector<std::unique_ptr<Surface>> _terrainParts;
+	std::mutex _cursorInfoMutex;
+	UnitSpriteCache *_unitSpriteCache;
 
-	void drawUnit(UnitSprite &unitSprite, Tile *unitTile, Tile *currTile, Position tileScreenPosition, bool topLayer, BattleUnit* movingUnit = nullptr);
-	void drawTerrain(Surface *surface);
+	void drawUnit(UnitSprite &unitSprite, const Camera *camera, Tile *unitTile, Tile *currTile, Position tileScreenPosition, bool topLayer, BattleUnit* movingUnit = nullptr);
+	void drawTerrain(Surface *surface, Camera *camera);
+	void drawTerrainCached();
+	void drawTerrainFull();
+	void drawTerrainParts(const std::vector<SDL_Rect> &rects);
+	bool canDrawTerrainThreaded() const;
+	void loadTerrainSprites();
+	void clearTerrain(Surface *surface);
+	void getTerrainBounds(const Camera *camera, int width, int height, int &beginX, int &beginY, int &beginZ, int &endX, int &endY, int &endZ) const;
+	uint64_t getTerrainCacheKey(Tile *tile);
 	int getTerrainLevel(const Position& pos, int size) const;
 	int getWallShade(TilePart part, Tile* tileFrot);
 	int _iconHeight, _iconWidth, _messageColor;
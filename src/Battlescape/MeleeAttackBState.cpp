@@ -22,6 +22,7 @@
 #include "BattlescapeState.h"
 #include "TileEngine.h"
 #include "Map.h"
+#include "Pathfinding.h"
 #include "Camera.h"
 #include "AIModule.h"
 #include "../Savegame/Tile.h"
@@ -177,7 +178,10 @@ void MeleeAttackBState::think()
 	// if the unit burns floor tiles, burn floor tiles
 	if (_unit->getSpecialAbility() == SPECAB_BURNFLOOR || _unit->getSpecialAbility() == SPECAB_BURN_AND_EXPLODE)
 	{
-		_parent->getSave()->getTile(_action.target)->ignite(15);
+		if (_parent->getSave()->getTile(_action.target)->ignite(15))
+		{
+			_parent->getSave()->getPathfinding()->invalidateReachable();
+		}
 	}
 	if (_hitNumber > 0 &&
 		// not performing a reaction attack
@@ -26,6 +26,7 @@
 #include "../Mod/Mod.h"
 #include "../Savegame/BattleUnit.h"
 #include "../Engine/Options.h"
+#include "../Engine/Trace.h"
 #include "../fmath.h"
 #include "BattlescapeGame.h"
 
@@ -71,7 +72,66 @@ Pathfinding::~Pathfinding()
  */
 PathfindingNode *Pathfinding::getNode(Position pos)
 {
-	return &_nodes[_save->getTileIndex(pos)];
+	PathfindingNode *node = &_nodes[_save->getTileIndex(pos)];
+	if (node->getEpoch() != _epoch)
+	{
+		// first visit in this search
+		node->reset(_epoch);
+	}
+	return node;
+}
+
+/**
+ * Starts a new search. Nodes are reset lazily by getNode,
+ * so only the tiles the search actually visits are touched.
+ */
+void Pathfinding::startSearch()
+{
+	++_epoch;
+	if (_epoch == 0)
+	{
+		// counter wrapped, old stamps could look current again
+		for (auto& pn : _nodes)
+		{
+			pn.reset(0);
+		}
+		_epoch = 1;
+	}
+	_openSet.clear();
+}
+
+/**
+ * Checks if the terrain allows any path between two positions, no matter the cost.
+ * Uses the chunk connectivity for the unit's kind of movement, so unreachable
+ * targets are rejected without searching the whole reachable space.
+ * @param unit Unit taking the path.
+ * @param startPosition The position to start from.
+ * @param endPosition The position we want to reach.
+ * @param bam Move type.
+ * @return False if no path can exist.
+ */
+bool Pathfinding::isConnected(const BattleUnit *unit, Position startPosition, Position endPosition, BattleActionMove bam)
+{
+	// everything getTUCost needs to decide if a step is possible, when units are ignored
+	const int key = ((unit->getArmor()->getSize() - 1) * 5 + getMovementType(unit, 0, bam)) * 5 + unit->getMovementType();
+	PathfindingRegions *regions = nullptr;
+	for (auto& r : _regions)
+	{
+		if (r.getKey() == key)
+		{
+			regions = &r;
+			break;
+		}
+	}
+	if (!regions)
+	{
+		_regions.push_back(PathfindingRegions(_save, key));
+		regions = &_regions.back();
+	}
+	_ignoreUnits = true;
+	regions->update(this, unit, bam);
+	_ignoreUnits = false;
+	return regions->isConnected(startPosition, endPosition);
 }
 
 /**
@@ -137,6 +197,9 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleAction
 	// check if destination is not blocked
 	if (isBlocked(_unit, destinationTile, O_FLOOR, bam, missileTarget) || isBlocked(_unit, destinationTile, O_OBJECT, bam, missileTarget)) return;
 
+	// no need to search if the terrain does not connect the two positions
+	if (bam != BAM_MISSILE && !isConnected(unit, startPosition, endPosition, bam)) return;
+
 	// Strafing move allowed only to adjacent squares on same z. "Same z" rule mainly to simplify walking render.
 	_strafeMove = bam == BAM_STRAFE && (startPosition.z == endPosition.z) &&
 							(abs(startPosition.x - endPosition.x) <= 1) && (abs(startPosition.y - endPosition.y) <= 1);
@@ -167,13 +230,106 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleAction
 	{
 		abortPath(); // if bresenham failed, we shouldn't keep the path it was attempting, in case A* fails too.
 	}
-	// Now try through A*.
-	if (!aStarPath(startPosition, endPosition, bam, missileTarget, sneak, maxTUCost))
+	// Now try through A*, or through the kept search tree when the player only moves the target.
+	bool found = _incremental ? incrementalPath(startPosition, endPosition, bam, sneak, maxTUCost) : aStarPath(startPosition, endPosition, bam, missileTarget, sneak, maxTUCost);
+	if (!found)
 	{
 		abortPath();
 	}
 }
 
+/**
+ * Calculates the shortest path like calculate, for a unit that stays in place while
+ * the target changes (like the player picking a destination). The Dijkstra search tree
+ * of the previous call is continued when the unit, its start and move type are the same
+ * and nothing on the map changed, so usually only a few nodes need to be expanded.
+ * @param unit Unit taking the path.
+ * @param endPosition The position we want to reach.
+ * @param bam Move type.
+ */
+void Pathfinding::calculateIncremental(BattleUnit *unit, Position endPosition, BattleActionMove bam)
+{
+	_incremental = true;
+	calculate(unit, endPosition, bam);
+	_incremental = false;
+}
+
+/**
+ * Finds the shortest path with Dijkstra's algorithm, continuing the search of the previous call if possible.
+ * The search stops as soon as the target is settled, the open set is kept for the next target.
+ * Any other search or a change of the map (see invalidateReachable) starts a new tree.
+ * @param startPosition The position to start from.
+ * @param endPosition The position we want to reach.
+ * @param bam Move type.
+ * @param sneak Is the unit sneaking?
+ * @param maxTUCost Maximum time units the path can cost.
+ * @return True if a path exists, false otherwise.
+ */
+bool Pathfinding::incrementalPath(Position startPosition, Position endPosition, BattleActionMove bam, bool sneak, int maxTUCost)
+{
+	const bool reuse = _treeEpoch == _epoch && _treeUnit == _unit && _treeArmor == _unit->getArmor() &&
+		_treeStart == startPosition && _treeBam == bam && _treeDirection == _unit->getDirection() &&
+		_treeMaxTUCost == maxTUCost && _treeSneak == sneak && _treeStrafe == _strafeMove;
+	if (!reuse)
+	{
+		startSearch();
+		PathfindingNode *start = getNode(startPosition);
+		start->connect({}, 0, 0);
+		_openSet.push(start);
+
+		_treeEpoch = _epoch;
+		_treeUnit = _unit;
+		_treeArmor = _unit->getArmor();
+		_treeStart = startPosition;
+		_treeBam = bam;
+		_treeDirection = _unit->getDirection();
+		_treeMaxTUCost = maxTUCost;
+		_treeSneak = sneak;
+		_treeStrafe = _strafeMove;
+	}
+
+	PathfindingNode *target = getNode(endPosition);
+	while (!target->isChecked() && !_openSet.empty())
+	{
+		PathfindingNode *currentNode = _openSet.pop();
+		Position const &currentPos = currentNode->getPosition();
+		currentNode->setChecked();
+
+		// Try all reachable neighbours.
+		for (int direction = 0; direction < 10; direction++)
+		{
+			PathfindingStep r = getTUCost(currentPos, direction, _unit, 0, bam);
+			if (r.cost.time == INVALID_MOVE_COST) // Skip unreachable / blocked
+				continue;
+
+			if (sneak && _save->getTile(r.pos)->getVisible()) r.cost.time *= 2; // avoid being seen
+			PathfindingNode *nextNode = getNode(r.pos);
+			if (nextNode->isChecked()) // Our algorithm means this node is already at minimum cost.
+				continue;
+			PathfindingCost totalTuCost = currentNode->getTUCost(false) + r.cost + r.penalty;
+			// If this node is unvisited or has only been visited from inferior paths...
+			if ((!nextNode->inOpenSet() || nextNode->getTUCost(false).time > totalTuCost.time) && totalTuCost.time <= maxTUCost)
+			{
+				nextNode->connect(totalTuCost, currentNode, direction);
+				_openSet.push(nextNode);
+			}
+		}
+	}
+	if (!target->isChecked())
+	{
+		// everything reachable is settled now, the tree still answers the next target
+		return false;
+	}
+
+	_path.clear();
+	for (PathfindingNode *pf = target; pf->getPrevNode(); pf = pf->getPrevNode())
+	{
+		_path.push_back(pf->getPrevDir());
+	}
+	_totalTUCost = target->getTUCost(false);
+	return true;
+}
+
 /**
  * Calculates the shortest path using a simple A-Star algorithm.
  * The unit information and movement type must have already been set.
@@ -187,16 +343,13 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleAction
  */
 bool Pathfinding::aStarPath(Position startPosition, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak, int maxTUCost)
 {
-	// reset every node, so we have to check them all
-	for (auto& pn : _nodes)
-	{
-		pn.reset();
-	}
+	TRACE_ZONE("Pathfinding::aStarPath");
+	startSearch();
 
 	// start position is the first one in our "open" list
 	PathfindingNode *start = getNode(startPosition);
 	start->connect({}, 0, 0, endPosition);
-	PathfindingOpenSet openList;
+	PathfindingOpenSet &openList = _openSet;
 	openList.push(start);
 	bool missile = (bam == BAM_MISSILE);
 	// if the open list is empty, we've reached the end
@@ -332,7 +485,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		{
 			// 2 or more voxels poking into this tile = no go
 			BattleUnit* overlaping = destinationTile[i]->getOverlappingUnit(_save, TUO_IGNORE_SMALL);
-			if (overlaping && overlaping != unit)
+			if (overlaping && overlaping != unit && !_ignoreUnits)
 			{
 				return {{INVALID_MOVE_COST, 0}};
 			}
@@ -865,7 +1018,7 @@ bool Pathfinding::isBlocked(const BattleUnit *unit, const Tile *tile, const int
 			 tileNorth->getMapData(O_OBJECT)->getBigWall() == BIGWALLEASTANDSOUTH))
 			return true; // blocking part
 	}
-	if (part == O_FLOOR)
+	if (part == O_FLOOR && !_ignoreUnits)
 	{
 		if (tile->getUnit())
 		{
@@ -1456,7 +1609,8 @@ bool Pathfinding::bresenhamPath(Position origin, Position target, BattleActionMo
 
 /**
  * Locates all tiles reachable to @a *unit with a TU cost no more than @a tuMax.
- * Uses Dijkstra's algorithm.
+ * Uses Dijkstra's algorithm. Results are cached until invalidateReachable is called,
+ * so repeated queries for the same unit and budget don't flood the map again.
  * @param unit Pointer to the unit.
  * @param tuMax The maximum cost of the path to each tile.
  * @return An array of reachable tiles, sorted in ascending order of cost. The first tile is the start location.
@@ -1468,14 +1622,22 @@ std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const Battle
 	int energyMax = unit->getEnergy() - cost.Energy;
 
 	PathfindingCost costMax = { tuMax, energyMax };
+	MovementType movementType = getMovementType(unit, 0, BAM_NORMAL);
 
-	for (auto& pn : _nodes)
+	for (const auto& entry : _reachableCache)
 	{
-		pn.reset();
+		if (entry.unit == unit && entry.armor == unit->getArmor() && entry.pos == start &&
+			entry.costMax.time == costMax.time && entry.costMax.energy == costMax.energy &&
+			entry.movementType == movementType && entry.faction == unit->getFaction())
+		{
+			return entry.tiles;
+		}
 	}
+
+	startSearch();
 	PathfindingNode *startNode = getNode(start);
 	startNode->connect({}, 0, 0);
-	PathfindingOpenSet unvisited;
+	PathfindingOpenSet &unvisited = _openSet;
 	unvisited.push(startNode);
 	std::vector<PathfindingNode*> reachable;
 	while (!unvisited.empty())
@@ -1512,9 +1674,46 @@ std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const Battle
 	{
 		tiles.push_back(_save->getTileIndex(pn->getPosition()));
 	}
+
+	ReachableCacheEntry entry = { unit, unit->getArmor(), start, costMax, movementType, unit->getFaction(), tiles };
+	if (_reachableCache.size() < ReachableCacheSize)
+	{
+		_reachableCache.push_back(std::move(entry));
+	}
+	else
+	{
+		_reachableCache[_reachableCacheNext] = std::move(entry);
+		_reachableCacheNext = (_reachableCacheNext + 1) % ReachableCacheSize;
+	}
 	return tiles;
 }
 
+/**
+ * Forgets all results of findReachable and the search tree kept for incremental paths.
+ * Called when a unit changes tile or is spotted, a door opens or closes, terrain is destroyed,
+ * a tile catches fire or fills with smoke, or the turn ends.
+ */
+void Pathfinding::invalidateReachable()
+{
+	_reachableCache.clear();
+	_reachableCacheNext = 0;
+	_treeEpoch = 0;
+}
+
+/**
+ * Marks the terrain around a tile as changed, after a door moved or something was destroyed.
+ * @param pos Position of the changed tile.
+ * @param radius How far from the tile steps can be affected.
+ */
+void Pathfinding::invalidateTerrain(Position pos, int radius)
+{
+	for (auto& r : _regions)
+	{
+		r.invalidate(pos, radius);
+	}
+	invalidateReachable();
+}
+
 /**
  * Gets the strafe move setting.
  * @return Strafe move.
@@ -20,6 +20,8 @@
 #include <vector>
 #include "Position.h"
 #include "PathfindingNode.h"
+#include "PathfindingOpenSet.h"
+#include "PathfindingRegions.h"
 #include "../Mod/MapData.h"
 
 namespace OpenXcom
@@ -28,6 +30,7 @@ namespace OpenXcom
 class SavedBattleGame;
 class Tile;
 class BattleUnit;
+class Armor;
 struct BattleActionCost;
 
 enum BattleActionMove : char;
@@ -46,7 +49,40 @@ private:
 
 	SavedBattleGame *_save;
 	std::vector<PathfindingNode> _nodes;
+	PathfindingOpenSet _openSet;
 	int _size;
+	/// Current search, nodes with other values are treated as unvisited.
+	Uint32 _epoch = 0;
+
+	/// Result of findReachable kept until something on the map changes.
+	struct ReachableCacheEntry
+	{
+		const BattleUnit *unit;
+		const Armor *armor;
+		Position pos;
+		PathfindingCost costMax;
+		MovementType movementType;
+		int faction;
+		std::vector<int> tiles;
+	};
+	constexpr static size_t ReachableCacheSize = 8;
+	std::vector<ReachableCacheEntry> _reachableCache;
+	size_t _reachableCacheNext = 0;
+	/// Connectivity of the map for each kind of mover, built on demand.
+	std::vector<PathfindingRegions> _regions;
+	/// Are units ignored by getTUCost? Used when building the connectivity.
+	bool _ignoreUnits = false;
+
+	/// Settings of the search tree kept by incrementalPath, it is valid while _treeEpoch is the current search.
+	Uint32 _treeEpoch = 0;
+	const BattleUnit *_treeUnit = nullptr;
+	const Armor *_treeArmor = nullptr;
+	Position _treeStart;
+	BattleActionMove _treeBam = {};
+	int _treeDirection = 0, _treeMaxTUCost = 0;
+	bool _treeSneak = false, _treeStrafe = false;
+	/// Should calculate continue the kept search tree instead of running A*?
+	bool _incremental = false;
 	BattleUnit *_unit;
 	bool _pathPreviewed;
 	bool _strafeMove;
@@ -56,6 +92,10 @@ private:
 
 	/// Gets the node at certain position.
 	PathfindingNode *getNode(Position pos);
+	/// Starts a new search, invalidating all nodes and the open set.
+	void startSearch();
+	/// Checks if terrain allows any path between two positions.
+	bool isConnected(const BattleUnit *unit, Position startPosition, Position endPosition, BattleActionMove bam);
 
 	/// Gets movement type of unit or movement of missile.
 	MovementType getMovementType(const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const;
@@ -67,6 +107,8 @@ private:
 	bool bresenhamPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
 	/// Tries to find a path between two positions.
 	bool aStarPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
+	/// Tries to find a path by continuing the search tree of the previous call.
+	bool incrementalPath(Position origin, Position target, BattleActionMove bam, bool sneak, int maxTUCost);
 	/// Determines whether a unit can fall down from this tile.
 	bool canFallDown(const Tile *destinationTile) const;
 	/// Determines whether a unit can fall down from this tile.
@@ -203,6 +245,8 @@ public:
 	~Pathfinding();
 	/// Calculates the shortest path.
 	void calculate(BattleUnit *unit, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget = 0, int maxTUCost = 1000);
+	/// Calculates the shortest path, reusing the previous search when only the target changed.
+	void calculateIncremental(BattleUnit *unit, Position endPosition, BattleActionMove bam);
 
 	/**
 	 * Converts direction to a vector. Direction starts north = 0 and goes clockwise.
@@ -267,6 +311,10 @@ public:
 	void setUnit(BattleUnit *unit);
 	/// Gets all reachable tiles, based on cost.
 	std::vector<int> findReachable(const BattleUnit *unit, const BattleActionCost &cost);
+	/// Forgets all cached findReachable results, needs to be called when units move or terrain changes.
+	void invalidateReachable();
+	/// Updates everything that depends on the terrain around a changed tile.
+	void invalidateTerrain(Position pos, int radius = 2);
 	/// Gets _totalTUCost; finds out whether we can hike somewhere in this turn or not.
 	int getTotalTUCost() const { return _totalTUCost.time; }
 	/// Gets the path preview setting.
@@ -25,7 +25,7 @@ namespace OpenXcom
  * Sets up a PathfindingNode.
  * @param pos Position.
  */
-PathfindingNode::PathfindingNode(Position pos) : _pos(pos), _prevNode(0), _prevDir(0), _tuGuess(0), _checked(0), _openentry(0)
+PathfindingNode::PathfindingNode(Position pos) : _pos(pos), _prevNode(0), _prevDir(0), _tuGuess(0), _epoch(0), _checked(0), _openentry(0)
 {
 
 }
@@ -49,9 +49,11 @@ Position PathfindingNode::getPosition() const
 
 /**
  * Resets the node.
+ * @param epoch Search the node is now part of.
  */
-void PathfindingNode::reset()
+void PathfindingNode::reset(Uint32 epoch)
 {
+	_epoch = epoch;
 	_checked = false;
 	_openentry = 0;
 }
@@ -91,6 +91,8 @@ private:
 	int _prevDir;
 	/// Approximate cost to reach goal position.
 	Sint16 _tuGuess;
+	/// Search this node was last reset for.
+	Uint32 _epoch;
 	/// Is best path find for this tile.
 	bool _checked;
 	// Invasive field needed by PathfindingOpenSet
@@ -103,8 +105,10 @@ public:
 	~PathfindingNode();
 	/// Gets the node position.
 	Position getPosition() const;
-	/// Resets the node.
-	void reset();
+	/// Resets the node for a new search.
+	void reset(Uint32 epoch);
+	/// Gets the search this node was last reset for.
+	Uint32 getEpoch() const { return _epoch; }
 	/// Is checked?
 	bool isChecked() const;
 	/// Marks the node as checked.
@@ -17,12 +17,21 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <assert.h>
+#include <algorithm>
 #include "PathfindingOpenSet.h"
 #include "PathfindingNode.h"
 
 namespace OpenXcom
 {
 
+/**
+ * Creates an empty set.
+ */
+PathfindingOpenSet::PathfindingOpenSet() : _min(0), _max(-1)
+{
+
+}
+
 /**
  * Cleans up all the entries still in set.
  */
@@ -32,14 +41,43 @@ PathfindingOpenSet::~PathfindingOpenSet()
 }
 
 /**
- * Keeps removing all discarded entries that have come to the top of the queue.
+ * Removes all entries. Only the buckets that were used are touched,
+ * so this is cheap even on big maps.
+ */
+void PathfindingOpenSet::clear()
+{
+	for (int i = _min; i <= _max; ++i)
+	{
+		_buckets[i] = -1;
+		_tails[i] = -1;
+	}
+	_entries.clear();
+	_min = 0;
+	_max = -1;
+}
+
+/**
+ * Keeps removing all discarded entries that have come to the front of the queue.
  */
 void PathfindingOpenSet::removeDiscarded()
 {
-	while (!_queue.empty() && _queue.top()._node->_openentry != _queue.top()._openentry)
+	while (_min <= _max)
 	{
-		_queue.pop();
+		int &first = _buckets[_min];
+		while (first != -1 && _entries[first]._node->_openentry != _entries[first]._openentry)
+		{
+			first = _entries[first]._next;
+		}
+		if (first != -1)
+		{
+			return;
+		}
+		_tails[_min] = -1;
+		++_min;
 	}
+	// nothing left, next push can start anywhere
+	_min = 0;
+	_max = -1;
 }
 
 /**
@@ -51,8 +89,9 @@ PathfindingNode *PathfindingOpenSet::pop()
 {
 	assert(!empty());
 
-	PathfindingNode *nd = _queue.top()._node;
-	_queue.pop();
+	int &first = _buckets[_min];
+	PathfindingNode *nd = _entries[first]._node;
+	first = _entries[first]._next;
 	nd->_openentry = 0;
 
 	// Discarded entries might be visible now.
@@ -70,12 +109,165 @@ void PathfindingOpenSet::push(PathfindingNode *node)
 {
 	assert(node->_openentry != 255u);
 
+	int cost = node->getTUCost(false).time * 4 + node->getTUGuess(); //HACK: this is not real cost, more rough approximation for algorithm, as bonus `getTUGuess` work more like gravity/potential than normal cost.
+	assert(cost >= 0);
+	if (cost >= (int)_buckets.size())
+	{
+		_buckets.resize(cost + 1, -1);
+		_tails.resize(cost + 1, -1);
+	}
+
 	OpenSetEntry entry = {};
 	entry._node = node;
-	entry._cost = node->getTUCost(false).time * 4 + node->getTUGuess(); //HACK: this is not real cost, more rough approximation for algorithm, as bonus `getTUGuess` work more like gravity/potential than normal cost.
+	entry._next = -1;
 	entry._openentry = ++node->_openentry; // next unique number, used to check if old recode is still valid.
-	_queue.push(entry);
+
+	// append at the end of the bucket, equal costs are checked first come first served
+	int index = (int)_entries.size();
+	if (_tails[cost] == -1)
+	{
+		_buckets[cost] = index;
+	}
+	else
+	{
+		_entries[_tails[cost]]._next = index;
+	}
+	_tails[cost] = index;
+	_entries.push_back(entry);
+
+	// the guess is not consistent, so a cost lower than the last pop is possible
+	if (empty())
+	{
+		_min = _max = cost;
+	}
+	else
+	{
+		_min = std::min(_min, cost);
+		_max = std::max(_max, cost);
+	}
 }
 
+#ifndef NDEBUG
+
+static auto dummyOpenSet = ([]
+{
+	PathfindingNode a(Position(0, 0, 0)), b(Position(1, 0, 0)), c(Position(2, 0, 0));
+	PathfindingOpenSet set;
+
+	a.connect({ 5, 0 }, 0, 0);
+	b.connect({ 3, 0 }, 0, 0);
+	c.connect({ 9, 0 }, 0, 0);
+	set.push(&a);
+	set.push(&b);
+	set.push(&c);
+	c.connect({ 1, 0 }, 0, 0); // better path found, old entry is discarded
+	set.push(&c);
+
+	assert(set.pop() == &c);
+	assert(set.pop() == &b);
+	assert(set.pop() == &a);
+	assert(set.empty());
+
+	set.clear();
+	assert(set.empty());
+
+	// equal costs come out in push order, even after a discarded entry
+	a.connect({ 4, 0 }, 0, 0);
+	b.connect({ 4, 0 }, 0, 0);
+	c.connect({ 6, 0 }, 0, 0);
+	set.push(&a);
+	set.push(&c);
+	set.push(&b);
+	c.connect({ 4, 0 }, 0, 0);
+	set.push(&c);
+
+	assert(set.pop() == &a);
+	assert(set.pop() == &b);
+	assert(set.pop() == &c);
+	assert(set.empty());
+
+	// same search on a grid full of equal cost paths must give the same path as a queue ordered by cost and push order
+	const int size = 8;
+	auto search = [&](std::vector<PathfindingNode> &nodes, auto &&push, auto &&pop, auto &&empty)
+	{
+		auto at = [&](int x, int y) -> PathfindingNode* { return (x < 0 || y < 0 || x >= size || y >= size) ? nullptr : &nodes[y * size + x]; };
+		const int dirs[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+		std::vector<PathfindingNode*> order;
+		nodes[0].connect({ 0, 0 }, 0, 0);
+		push(&nodes[0]);
+		while (!empty())
+		{
+			PathfindingNode *nd = pop();
+			if (nd->isChecked())
+			{
+				continue;
+			}
+			nd->setChecked();
+			order.push_back(nd);
+			for (int dir = 0; dir < 4; ++dir)
+			{
+				PathfindingNode *next = at(nd->getPosition().x + dirs[dir][0], nd->getPosition().y + dirs[dir][1]);
+				if (!next || next->isChecked())
+				{
+					continue;
+				}
+				PathfindingCost cost = nd->getTUCost(false) + PathfindingCost{ 1 + (next->getPosition().x == 3), 0 };
+				if (next->getPrevNode() == 0 || cost.time < next->getTUCost(false).time)
+				{
+					next->connect(cost, nd, dir);
+					push(next);
+				}
+			}
+		}
+		return order;
+	};
+	auto makeNodes = [&]
+	{
+		std::vector<PathfindingNode> nodes;
+		for (int i = 0; i < size * size; ++i)
+		{
+			nodes.push_back(PathfindingNode(Position(i % size, i / size, 0)));
+		}
+		return nodes;
+	};
+
+	std::vector<PathfindingNode> nodesSet = makeNodes();
+	set.clear();
+	auto orderSet = search(nodesSet,
+		[&](PathfindingNode *nd) { set.push(nd); },
+		[&] { return set.pop(); },
+		[&] { return set.empty(); }
+	);
+
+	std::vector<PathfindingNode> nodesRef = makeNodes();
+	std::vector<std::pair<int, PathfindingNode*>> ref; // ordered by cost, ties by push order
+	auto orderRef = search(nodesRef,
+		[&](PathfindingNode *nd) { ref.push_back(std::make_pair(nd->getTUCost(false).time * 4, nd)); },
+		[&]
+		{
+			auto best = std::min_element(ref.begin(), ref.end(), [](const auto &l, const auto &r) { return l.first < r.first; });
+			PathfindingNode *nd = best->second;
+			bool stale = best->first != nd->getTUCost(false).time * 4;
+			ref.erase(best);
+			return stale ? &nodesRef[0] : nd; // origin is already checked, so it is skipped like a discarded entry
+		},
+		[&] { return ref.empty(); }
+	);
+
+	assert(orderSet.size() == orderRef.size());
+	for (size_t i = 0; i < orderSet.size(); ++i)
+	{
+		assert(orderSet[i]->getPosition() == orderRef[i]->getPosition());
+	}
+	for (int i = 0; i < size * size; ++i)
+	{
+		assert(nodesSet[i].getPrevDir() == nodesRef[i].getPrevDir());
+		assert(nodesSet[i].getTUCost(false).time == nodesRef[i].getTUCost(false).time);
+	}
+
+	return 0;
+})();
+
+#endif
 
 }
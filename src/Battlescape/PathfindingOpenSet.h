@@ -17,7 +17,7 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
-#include <queue>
+#include <vector>
 #include <SDL_stdinc.h>
 
 namespace OpenXcom
@@ -28,45 +28,42 @@ class PathfindingNode;
 struct OpenSetEntry
 {
 	PathfindingNode *_node;
-	Sint16 _cost;
+	/// Index of the next entry in the same bucket, or -1.
+	int _next;
 	Uint8 _openentry;
 };
 
-/**
- * Helper class to compare entries through pointers.
- */
-class EntryCompare
-{
-public:
-	/**
-	 * Compares entries @a *a and @a *b.
-	 * @param a Pointer to first entry.
-	 * @param b Pointer to second entry.
-	 * @return True if entry @a *b must come before @a *a.
-	 */
-	bool operator()(const OpenSetEntry& a, const OpenSetEntry& b) const
-	{
-		return b._cost < a._cost;
-	}
-};
-
 /**
  * A class that holds references to the nodes to be examined in pathfinding.
+ * Costs are small integers, so entries are kept in one bucket per cost
+ * instead of a heap. Entries with the same cost come out in the order they were pushed.
+ * All entries live in one pool that is reused between searches.
  */
 class PathfindingOpenSet
 {
 public:
+	/// Creates an empty set.
+	PathfindingOpenSet();
 	/// Cleans up the set and frees allocated memory.
 	~PathfindingOpenSet();
+	/// Removes all entries, keeping the allocated memory.
+	void clear();
 	/// Gets the next node to check.
 	PathfindingNode *pop();
 	/// Adds a node to the set.
 	void push(PathfindingNode *node);
 	/// Is the set empty?
-	bool empty() const { return _queue.empty(); }
+	bool empty() const { return _min > _max; }
 
 private:
-	std::priority_queue<OpenSetEntry, std::vector<OpenSetEntry>, EntryCompare> _queue;
+	/// First entry of each cost bucket, or -1.
+	std::vector<int> _buckets;
+	/// Last entry of each cost bucket, or -1.
+	std::vector<int> _tails;
+	/// Pool of all entries pushed since the last clear.
+	std::vector<OpenSetEntry> _entries;
+	/// Lowest and highest cost that can still have entries.
+	int _min, _max;
 
 	/// Removes reachable discarded entries.
 	void removeDiscarded();
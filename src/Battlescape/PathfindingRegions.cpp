@@ -0,0 +1,259 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <numeric>
+#include "PathfindingRegions.h"
+#include "Pathfinding.h"
+#include "../Savegame/SavedBattleGame.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Sets up the connectivity for one kind of mover.
+ * @param save Pointer to the battle.
+ * @param key Kind of mover, see Pathfinding::isConnected.
+ */
+PathfindingRegions::PathfindingRegions(SavedBattleGame *save, int key) : _save(save), _key(key), _chunksX(0), _chunksY(0), _dirty(true)
+{
+
+}
+
+/**
+ * Deletes the connectivity.
+ */
+PathfindingRegions::~PathfindingRegions()
+{
+
+}
+
+/**
+ * Gets the root of a union-find set, shortening the way there.
+ * @param i Index of an element.
+ * @return Index of the root.
+ */
+int PathfindingRegions::findRoot(int i)
+{
+	while (_parent[i] != i)
+	{
+		_parent[i] = _parent[_parent[i]];
+		i = _parent[i];
+	}
+	return i;
+}
+
+/**
+ * Joins two union-find sets.
+ * @param a Index of an element of the first set.
+ * @param b Index of an element of the second set.
+ */
+void PathfindingRegions::join(int a, int b)
+{
+	a = findRoot(a);
+	b = findRoot(b);
+	if (a != b)
+	{
+		_parent[std::max(a, b)] = std::min(a, b);
+	}
+}
+
+/**
+ * Joins all tiles of a chunk that can step into each other (in any direction) into regions,
+ * and collects the steps that leave the chunk.
+ * @param chunk Index of the chunk.
+ * @param pathfinding Pathfinding used to check the steps, set to ignore units.
+ * @param unit Any unit of this kind of mover.
+ * @param bam Move type.
+ */
+void PathfindingRegions::buildChunk(int chunk, const Pathfinding *pathfinding, const BattleUnit *unit, BattleActionMove bam)
+{
+	const int x0 = (chunk % _chunksX) * ChunkSize;
+	const int y0 = (chunk / _chunksX) * ChunkSize;
+	const int x1 = std::min(x0 + ChunkSize, _save->getMapSizeX());
+	const int y1 = std::min(y0 + ChunkSize, _save->getMapSizeY());
+	const int z1 = _save->getMapSizeZ();
+	auto inChunk = [&](Position p)
+	{
+		return p.x >= x0 && p.x < x1 && p.y >= y0 && p.y < y1;
+	};
+	auto forEachTile = [&](auto func)
+	{
+		for (int z = 0; z < z1; ++z)
+		{
+			for (int y = y0; y < y1; ++y)
+			{
+				for (int x = x0; x < x1; ++x)
+				{
+					func(Position(x, y, z));
+				}
+			}
+		}
+	};
+
+	forEachTile([&](Position pos)
+	{
+		int i = _save->getTileIndex(pos);
+		_parent[i] = i;
+	});
+	auto &portals = _portals[chunk];
+	portals.clear();
+
+	forEachTile([&](Position pos)
+	{
+		const int i = _save->getTileIndex(pos);
+		for (int dir = 0; dir < 10; ++dir)
+		{
+			Position next;
+			Pathfinding::directionToVector(dir, &next);
+			next += pos;
+			if (!_save->getTile(next))
+			{
+				continue;
+			}
+			if (inChunk(next))
+			{
+				// stairs can move the step a level up or down, skip only if every outcome is already joined
+				const int root = findRoot(i);
+				bool joined = findRoot(_save->getTileIndex(next)) == root;
+				if (joined && dir < Pathfinding::DIR_UP)
+				{
+					for (int dz = -1; dz <= 1; dz += 2)
+					{
+						Position other = next + Position(0, 0, dz);
+						joined = joined && (!_save->getTile(other) || findRoot(_save->getTileIndex(other)) == root);
+					}
+				}
+				if (joined)
+				{
+					continue;
+				}
+			}
+
+			PathfindingStep r = pathfinding->getTUCost(pos, dir, unit, 0, bam);
+			if (r.cost.time == Pathfinding::INVALID_MOVE_COST)
+			{
+				continue;
+			}
+			const int j = _save->getTileIndex(r.pos);
+			if (inChunk(r.pos))
+			{
+				join(i, j);
+			}
+			else
+			{
+				portals.push_back(std::make_pair(i, j));
+			}
+		}
+	});
+
+	forEachTile([&](Position pos)
+	{
+		int i = _save->getTileIndex(pos);
+		_region[i] = findRoot(i);
+	});
+}
+
+/**
+ * Marks the chunks around a position as changed, they will be rebuilt on next update.
+ * @param pos Position of the changed tile.
+ * @param radius Distance in tiles that steps can be affected by the change.
+ */
+void PathfindingRegions::invalidate(Position pos, int radius)
+{
+	if (_region.empty())
+	{
+		return; // nothing built yet
+	}
+	const int minX = std::max(pos.x - radius, 0) / ChunkSize;
+	const int minY = std::max(pos.y - radius, 0) / ChunkSize;
+	const int maxX = std::min(pos.x + radius, _save->getMapSizeX() - 1) / ChunkSize;
+	const int maxY = std::min(pos.y + radius, _save->getMapSizeY() - 1) / ChunkSize;
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			_dirtyChunks[y * _chunksX + x] = true;
+			_dirty = true;
+		}
+	}
+}
+
+/**
+ * Rebuilds the regions of changed chunks (all of them the first time)
+ * and joins the regions through the portals into components.
+ * @param pathfinding Pathfinding used to check the steps, set to ignore units.
+ * @param unit Any unit of this kind of mover.
+ * @param bam Move type.
+ */
+void PathfindingRegions::update(const Pathfinding *pathfinding, const BattleUnit *unit, BattleActionMove bam)
+{
+	if (!_dirty)
+	{
+		return;
+	}
+	const int size = _save->getMapSizeXYZ();
+	if (_region.empty())
+	{
+		_chunksX = (_save->getMapSizeX() + ChunkSize - 1) / ChunkSize;
+		_chunksY = (_save->getMapSizeY() + ChunkSize - 1) / ChunkSize;
+		_region.resize(size);
+		_component.resize(size);
+		_parent.resize(size);
+		_portals.resize(_chunksX * _chunksY);
+		_dirtyChunks.assign(_chunksX * _chunksY, true);
+	}
+
+	for (int chunk = 0; chunk < _chunksX * _chunksY; ++chunk)
+	{
+		if (_dirtyChunks[chunk])
+		{
+			buildChunk(chunk, pathfinding, unit, bam);
+			_dirtyChunks[chunk] = false;
+		}
+	}
+
+	// regions are few compared to tiles, but using tile indexes as ids keeps this simple
+	std::iota(_parent.begin(), _parent.end(), 0);
+	for (const auto& portals : _portals)
+	{
+		for (const auto& step : portals)
+		{
+			join(_region[step.first], _region[step.second]);
+		}
+	}
+	for (int i = 0; i < size; ++i)
+	{
+		_component[i] = findRoot(_region[i]);
+	}
+	_dirty = false;
+}
+
+/**
+ * Checks if a path between two positions can exist at all, when nothing blocks it but terrain.
+ * The result is only valid after update.
+ * @param a First position.
+ * @param b Second position.
+ * @return False if no path can exist.
+ */
+bool PathfindingRegions::isConnected(Position a, Position b) const
+{
+	return _component[_save->getTileIndex(a)] == _component[_save->getTileIndex(b)];
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vector>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class Pathfinding;
+class BattleUnit;
+
+enum BattleActionMove : char;
+
+/**
+ * Connectivity of the battlescape map for one kind of mover (movement type and size),
+ * ignoring units. The map is cut into chunks of map block size; tiles of a chunk that
+ * reach each other are one region, and regions of neighbouring chunks are joined through
+ * the steps that cross the chunk border. Two positions in different components can never
+ * be connected by a path, so such searches can be rejected without expanding any node.
+ */
+class PathfindingRegions
+{
+public:
+	/// Size of the chunks, same as the map blocks.
+	static constexpr int ChunkSize = 10;
+
+private:
+	SavedBattleGame *_save;
+	int _key;
+	int _chunksX, _chunksY;
+	/// Local region of each tile, index of the region's root tile.
+	std::vector<int> _region;
+	/// Global component of each tile.
+	std::vector<int> _component;
+	/// Union-find scratch space, one entry per tile.
+	std::vector<int> _parent;
+	/// Steps from one chunk into another, per chunk.
+	std::vector<std::vector<std::pair<int, int> > > _portals;
+	std::vector<bool> _dirtyChunks;
+	bool _dirty;
+
+	/// Gets the root of a union-find set.
+	int findRoot(int i);
+	/// Joins two union-find sets.
+	void join(int a, int b);
+	/// Finds the regions and portals of one chunk.
+	void buildChunk(int chunk, const Pathfinding *pathfinding, const BattleUnit *unit, BattleActionMove bam);
+public:
+	/// Creates the connectivity for a kind of mover, nothing is computed yet.
+	PathfindingRegions(SavedBattleGame *save, int key);
+	/// Cleans up the connectivity.
+	~PathfindingRegions();
+	/// Gets the kind of mover.
+	int getKey() const { return _key; }
+	/// Marks the chunks around a position as changed.
+	void invalidate(Position pos, int radius);
+	/// Rebuilds the changed chunks and the components.
+	void update(const Pathfinding *pathfinding, const BattleUnit *unit, BattleActionMove bam);
+	/// Can a path between two positions exist at all?
+	bool isConnected(Position a, Position b) const;
+};
+
+}
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <assert.h>
+#include <atomic>
 #include <set>
 #include "TileEngine.h"
 #include "AIModule.h"
@@ -40,6 +41,8 @@
 #include "../Mod/RuleSkill.h"
 #include "Pathfinding.h"
 #include "../Engine/Options.h"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/Trace.h"
 #include "ProjectileFlyBState.h"
 #include "MeleeAttackBState.h"
 #include "../fmath.h"
@@ -49,6 +52,34 @@ namespace OpenXcom
 namespace
 {
 
+/**
+ * Last tile looked up by voxelCheck.
+ * Kept per thread, so line of sight checks can run on worker threads.
+ */
+struct VoxelCheckCache
+{
+	unsigned generation = 0;
+	Position pos;
+	Tile *tile = nullptr;
+	Tile *tileBelow = nullptr;
+};
+
+thread_local VoxelCheckCache voxelCache;
+
+/// Source of cache tags, unique for every TileEngine and every flush.
+std::atomic<unsigned> voxelCacheGenerations(0);
+
+/**
+ * Tiles already reached by the current findTilesInFOV search of this thread.
+ */
+struct FOVScratch
+{
+	std::vector<Uint32> stamp;
+	Uint32 epoch = 0;
+};
+
+thread_local FOVScratch fovScratch;
+
 /**
  * Calculates a line trajectory, using bresenham algorithm in 3D.
  * @param origin Origin.
@@ -894,7 +925,7 @@ constexpr Position TileEngine::voxelTileCenter;
  * @param maxDarknessToSeeUnits Threshold of darkness for LoS calculation.
  */
 TileEngine::TileEngine(SavedBattleGame *save, Mod *mod) :
-	_save(save), _voxelData(mod->getVoxelData()), _inventorySlotGround(mod->getInventoryGround()), _personalLighting(true), _cacheTile(0), _cacheTileBelow(0),
+	_save(save), _voxelData(mod->getVoxelData()), _inventorySlotGround(mod->getInventoryGround()), _personalLighting(true), _cacheGeneration(++voxelCacheGenerations),
 	_maxViewDistance(mod->getMaxViewDistance()), _maxViewDistanceSq(_maxViewDistance * _maxViewDistance),
 	_maxVoxelViewDistance(_maxViewDistance * 16), _maxDarknessToSeeUnits(mod->getMaxDarknessToSeeUnits()),
 	_maxStaticLightDistance(mod->getMaxStaticLightDistance()), _maxDynamicLightDistance(mod->getMaxDynamicLightDistance()),
@@ -903,7 +934,7 @@ TileEngine::TileEngine(SavedBattleGame *save, Mod *mod) :
 	_blockVisibility.resize(save->getMapSizeXYZ());
 	_lightPropagationTerrainBlocking.resize(save->getMapSizeXYZ());
 	_lightPropagationTempNeedUpdate.resize(save->getMapSizeXYZ());
-	_cacheTilePos = invalid;
+	_voxelGrid.init(save, _voxelData);
 
 	if (Options::oxceTogglePersonalLightType == 2)
 	{
@@ -1022,14 +1053,19 @@ void TileEngine::calculateTerrainBackground(MapSubset gs)
 
 /**
   * Recalculates lighting for the terrain: objects,items.
+  * @param gs Area where items could have changed.
+  * @param affected Area where terrain or static light changed.
   */
-void TileEngine::calculateTerrainItems(MapSubset gs)
+void TileEngine::calculateTerrainItems(MapSubset gs, MapSubset affected)
 {
+	const auto scope = mapAreaExpand(gs, getMaxDynamicLightDistance() - 1);
+	std::map<std::pair<int, int>, LightSource> found;
+
 	// add lighting of terrain
 	iterateTiles(
 		_save,
-		mapAreaExpand(gs, getMaxDynamicLightDistance() - 1),
-		[&](Tile* tile)
+		scope,
+		[&](Tile* tile, int index)
 		{
 			int currLight = 0;
 
@@ -1051,19 +1087,30 @@ void TileEngine::calculateTerrainItems(MapSubset gs)
 			{
 				currLight = getMaxDynamicLightDistance() - 1;
 			}
-			addLight(gs, tile->getPosition(), currLight, LL_ITEMS);
+			if (currLight > 0)
+			{
+				auto& source = found[std::make_pair(index, 0)];
+				source.center = tile->getPosition();
+				source.power = currLight;
+			}
 		}
 	);
+
+	updateDynamicLights(LL_ITEMS, scope, found, affected);
 }
 
 /**
   * Recalculates lighting for the units.
+  * Every unit is checked, they are few and any of them could have moved.
+  * @param affected Area where terrain or static light changed.
   */
-void TileEngine::calculateUnitLighting(MapSubset gs)
+void TileEngine::calculateUnitLighting(MapSubset affected)
 {
+	std::map<std::pair<int, int>, LightSource> found;
+
 	for (BattleUnit *unit : *_save->getUnits())
 	{
-		if (unit->isOut())
+		if (unit->isOut() || !unit->getTile())
 		{
 			continue;
 		}
@@ -1109,16 +1156,24 @@ void TileEngine::calculateUnitLighting(MapSubset gs)
 		{
 			currLight = getMaxDynamicLightDistance() - 1;
 		}
+		if (currLight <= 0)
+		{
+			continue;
+		}
 		const auto size = unit->getArmor()->getSize();
 		const auto pos = unit->getPosition();
 		for (int x = 0; x < size; ++x)
 		{
 			for (int y = 0; y < size; ++y)
 			{
-				addLight(gs, pos + Position(x, y, 0), currLight, LL_UNITS);
+				auto& source = found[std::make_pair(unit->getId(), x + y * size)];
+				source.center = pos + Position(x, y, 0);
+				source.power = currLight;
 			}
 		}
 	}
+
+	updateDynamicLights(LL_UNITS, MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() }, found, affected);
 }
 
 void TileEngine::calculateLighting(LightLayers layer, Position position, int eventRadius, bool terrianChanged)
@@ -1127,6 +1182,9 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 	auto gsDynamic = gsMap;
 	auto gsStatic = gsDynamic;
 
+	// shade, smoke and terrain all change what units can see
+	invalidateVisibility();
+
 	if (position != invalid)
 	{
 		gsDynamic = mapArea(position, eventRadius + getMaxDynamicLightDistance());
@@ -1145,6 +1203,7 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 				const auto* mapData = tile->getMapData(O_OBJECT);
 				auto& cache = _blockVisibility[index];
 
+				_voxelGrid.update(_save, tile);
 				cache = {};
 				cache.height = -tile->getTerrainLevel();
 				if (mapData)
@@ -1202,42 +1261,55 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 		);
 	}
 
-	iterateTilesLightMaxBound(_save, position, eventRadius, getMaxDynamicLightDistance(), gsMap, _lightPropagationTempNeedUpdate, _lightPropagationTerrainBlocking);
+	// dynamic lights that could be blocked or outshone differently need tracing again
+	auto affected = MapSubset{};
+	if (layer <= LL_FIRE)
+	{
+		affected = gsStatic;
+	}
+	else if (terrianChanged)
+	{
+		affected = position != invalid ? mapArea(position, eventRadius + 1) : gsMap;
+	}
 
 	if (layer <= LL_FIRE)
 	{
+		iterateTilesLightMaxBound(_save, position, eventRadius, getMaxDynamicLightDistance(), gsMap, _lightPropagationTempNeedUpdate, _lightPropagationTerrainBlocking);
+
+		auto& light = _save->getTileHotData().light;
 		iterateTiles(
 			_save,
 			gsStatic,
-			[&](Tile* tile, int index)
+			[&](int index)
 			{
-				if (_lightPropagationTempNeedUpdate[index]) tile->resetLightMulti(layer);
+				if (_lightPropagationTempNeedUpdate[index])
+				{
+					for (int l = layer; l <= LL_FIRE; ++l)
+					{
+						light[index][l] = 0;
+					}
+				}
 			}
 		);
 	}
 
-	iterateTiles(
-		_save,
-		gsDynamic,
-		[&](Tile* tile, int index)
-		{
-			if (_lightPropagationTempNeedUpdate[index]) tile->resetLightMulti(std::max(layer, LL_ITEMS));
-		}
-	);
-
 	if (layer <= LL_AMBIENT) calculateSunShading(gsStatic);
 	if (layer <= LL_FIRE) calculateTerrainBackground(gsStatic);
-	if (layer <= LL_ITEMS) calculateTerrainItems(gsDynamic);
-	if (layer <= LL_UNITS) calculateUnitLighting(gsDynamic);
+	if (layer <= LL_ITEMS) calculateTerrainItems(gsDynamic, affected);
+	if (layer <= LL_UNITS) calculateUnitLighting(affected);
 }
 
 /**
- * Adds circular light pattern starting from center and losing power with distance travelled.
+ * Spreads a circular light pattern starting from center and losing power with distance travelled.
+ * @param gs Tiles to light.
  * @param center Center.
  * @param power Power.
  * @param layer Light is separated in 4 layers: Ambient, Tiles, Items, Units.
+ * @param getTarget Gets the light a tile already has, or -1 to skip the tile.
+ * @param setLight Called with every tile that gets brighter and its new light.
  */
-void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers layer)
+template<typename TargetFunc, typename LightFunc>
+void TileEngine::propagateLight(MapSubset gs, Position center, int power, LightLayers layer, TargetFunc &&getTarget, LightFunc &&setLight) const
 {
 	if (power <= 0)
 	{
@@ -1267,20 +1339,16 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			const auto target = tile->getPosition();
 			const auto diff = target - center;
 			const auto distance = (int)Round(Position::distance(target.toVoxel(), center.toVoxel()) / Position::TileXY);
-			const auto targetLight = tile->getLightMulti(layer);
+			const auto targetLight = getTarget(tile, idx);
 			auto currLight = power - distance;
 
-			if (currLight <= targetLight)
+			if (targetLight < 0 || currLight <= targetLight)
 			{
 				return;
 			}
 			if (clasicLighting)
 			{
-				tile->addLight(currLight, layer);
-				return;
-			}
-			if (_lightPropagationTempNeedUpdate[idx] == 0)
-			{
+				setLight(tile, currLight);
 				return;
 			}
 
@@ -1374,29 +1442,191 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			currLight = (lightA + lightB) / 2;
 			if (currLight > targetLight)
 			{
-				tile->addLight(currLight, layer);
+				setLight(tile, currLight);
 			}
 		}
 	);
 }
 
+/**
+ * Adds circular light pattern starting from center and losing power with distance travelled.
+ * Only tiles that need an update are traced, other light of the tile is not replaced.
+ * @param gs Tiles to light.
+ * @param center Center.
+ * @param power Power.
+ * @param layer Light is separated in 4 layers: Ambient, Tiles, Items, Units.
+ */
+void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers layer)
+{
+	const auto clasicLighting = !(getEnhancedLighting() & ((layer == LL_FIRE ? 1 : 0) | (layer == LL_ITEMS ? 2 : 0) | (layer == LL_UNITS ? 4 : 0)));
+	propagateLight(gs, center, power, layer,
+		[&](Tile* tile, int idx)
+		{
+			return clasicLighting || _lightPropagationTempNeedUpdate[idx] ? tile->getLightMulti(layer) : -1;
+		},
+		[&](Tile* tile, int light)
+		{
+			tile->addLight(light, layer);
+		}
+	);
+}
+
+/**
+ * Gets the tiles a dynamic light source can reach, on all levels.
+ * @param source Light source.
+ * @return Square around the source, inside the map.
+ */
+MapSubset TileEngine::getLightArea(const LightSource &source) const
+{
+	return MapSubset::intersection(mapArea(source.center, source.power - 1), MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() });
+}
+
+/**
+ * Finds the light a dynamic source gives to every tile in its range.
+ * Other dynamic lights are ignored, so the result does not depend on which
+ * source is traced first, and only sources that change need tracing again.
+ * Only reads the battle, so different sources can be traced on worker threads.
+ * @param source Light source, its light is replaced.
+ * @param layer Items or units.
+ */
+void TileEngine::traceLight(LightSource &source, LightLayers layer) const
+{
+	const auto area = getLightArea(source);
+	source.light.assign(area.size_x() * area.size_y() * _save->getMapSizeZ(), 0);
+	propagateLight(area, source.center, source.power, layer,
+		[&](Tile* tile, int idx)
+		{
+			return tile->getLightMulti(LL_FIRE);
+		},
+		[&](Tile* tile, int light)
+		{
+			const auto pos = tile->getPosition();
+			source.light[(pos.z * area.size_y() + pos.y - area.beg_y) * area.size_x() + pos.x - area.beg_x] = light;
+		}
+	);
+}
+
+/**
+ * Updates the lights of one dynamic layer.
+ * Sources that moved, changed power, appeared or disappeared are traced again,
+ * like the ones that could reach an area where terrain or static light changed.
+ * Only the tiles these sources reach, before and after, get their light
+ * rebuilt from all the sources of the layer.
+ * @param layer Items or units.
+ * @param scope Area where sources were looked for, sources there that are not found are removed.
+ * @param found Sources found, keyed like the stored ones. Their light gets moved away.
+ * @param affected Area where terrain or static light changed.
+ */
+void TileEngine::updateDynamicLights(LightLayers layer, MapSubset scope, std::map<std::pair<int, int>, LightSource> &found, MapSubset affected)
+{
+	auto& sources = (layer == LL_ITEMS ? _itemLights : _unitLights);
+	std::vector<MapSubset> dirty;
+	std::vector<LightSource*> changed;
+
+	auto addDirty = [&](MapSubset area)
+	{
+		// merge overlapping areas, a moving light covers almost the same tiles as before
+		for (auto& d : dirty)
+		{
+			if (MapSubset::intersection(d, area))
+			{
+				d = MapSubset::boundBox(d, area);
+				return;
+			}
+		}
+		dirty.push_back(area);
+	};
+
+	for (auto it = sources.begin(); it != sources.end();)
+	{
+		auto& source = it->second;
+		auto f = found.find(it->first);
+		if (f == found.end())
+		{
+			if (MapSubset::intersection(scope, MapSubset::fromPoint(source.center.x, source.center.y)))
+			{
+				addDirty(getLightArea(source));
+				it = sources.erase(it);
+				continue;
+			}
+		}
+		else if (f->second.center != source.center || f->second.power != source.power)
+		{
+			addDirty(getLightArea(source));
+			it = sources.erase(it);
+			continue;
+		}
+		else
+		{
+			found.erase(f);
+			if (MapSubset::intersection(affected, getLightArea(source)))
+			{
+				addDirty(getLightArea(source));
+				changed.push_back(&source);
+			}
+		}
+		++it;
+	}
+	for (auto& f : found)
+	{
+		auto& source = sources[f.first];
+		source = std::move(f.second);
+		addDirty(getLightArea(source));
+		changed.push_back(&source);
+	}
+
+	ThreadPool::parallelFor((int)changed.size(), [&](int i)
+	{
+		traceLight(*changed[i], layer);
+	});
+
+	auto& light = _save->getTileHotData().light;
+	for (auto& d : dirty)
+	{
+		iterateTiles(
+			_save,
+			d,
+			[&](int index)
+			{
+				light[index][layer] = 0;
+			}
+		);
+		for (auto& s : sources)
+		{
+			const auto& source = s.second;
+			const auto area = getLightArea(source);
+			iterateTiles(
+				_save,
+				MapSubset::intersection(d, area),
+				[&](Tile* tile, int index)
+				{
+					const auto pos = tile->getPosition();
+					auto& current = light[index][layer];
+					current = std::max<Uint8>(current, source.light[(pos.z * area.size_y() + pos.y - area.beg_y) * area.size_x() + pos.x - area.beg_x]);
+				}
+			);
+		}
+	}
+}
+
 /**
  * Setups the internal event visibility search space reduction system. This system defines a narrow circle sector around
  * a given event as viewed from an external observer. This allows narrowing down which tiles/units may need to be updated for
  * the observer based on the event affecting visibility at the event itself and beyond it in its direction.
  * Imagines a circle around the event of eventRadius, calculates its tangents, and places points at the circle's tangent
  * intersections for later bounds checking.
+ * @param sector Sector to set up.
  * @param observerPos Position of the observer of this event.
  * @param eventPos The centre of the event. Ie a moving unit's position, centre of explosion, a single destroyed tile, etc.
  * @param eventRadius Radius big enough to fully envelop the event. Ie for a single tile change, set radius to 1.
  * @return true if area is unlimited.
  *
 */
-bool TileEngine::setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius)
+bool TileEngine::setupEventVisibilitySector(EventVisibilitySector &sector, const Position &observerPos, const Position &eventPos, const int &eventRadius) const
 {
 	if (eventRadius == 0 || eventPos == Position(-1, -1, -1) || Position::distance2dSq(observerPos, eventPos) <= eventRadius * eventRadius)
 	{
-		_eventVisibilityObserverPos = Position{ -1, -1, -1 };
+		sector.observerPos = Position{ -1, -1, -1 };
 		return true;
 	}
 	else
@@ -1410,11 +1640,11 @@ bool TileEngine::setupEventVisibilitySector(const Position &observerPos, const P
 		float t1 = b - a;
 		float t2 = b + a;
 		//Define the points where the lines tangent to the circle intersect it. Note: resulting positions are relative to observer, not in direct tile space.
-		_eventVisibilitySectorL.x = roundf(eventPos.x + eventRadius * sinf(t1)) - observerPos.x;
-		_eventVisibilitySectorL.y = roundf(eventPos.y - eventRadius * cosf(t1)) - observerPos.y;
-		_eventVisibilitySectorR.x = roundf(eventPos.x - eventRadius * sinf(t2)) - observerPos.x;
-		_eventVisibilitySectorR.y = roundf(eventPos.y + eventRadius * cosf(t2)) - observerPos.y;
-		_eventVisibilityObserverPos = observerPos;
+		sector.left.x = roundf(eventPos.x + eventRadius * sinf(t1)) - observerPos.x;
+		sector.left.y = roundf(eventPos.y - eventRadius * cosf(t1)) - observerPos.y;
+		sector.right.x = roundf(eventPos.x - eventRadius * sinf(t2)) - observerPos.x;
+		sector.right.y = roundf(eventPos.y + eventRadius * cosf(t2)) - observerPos.y;
+		sector.observerPos = observerPos;
 		return false;
 	}
 }
@@ -1422,17 +1652,18 @@ bool TileEngine::setupEventVisibilitySector(const Position &observerPos, const P
 /**
  * Checks whether toCheck is within a previously setup eventVisibilitySector. See setupEventVisibilitySector(...).
  * May be used to rapidly reduce the search space when updating unit and tile visibility.
+ * @param sector The sector.
  * @param toCheck The position to check.
  * @return true if within the circle sector.
  */
-inline bool TileEngine::inEventVisibilitySector(const Position &toCheck) const
+inline bool TileEngine::inEventVisibilitySector(const EventVisibilitySector &sector, const Position &toCheck) const
 {
-	if (_eventVisibilityObserverPos != Position{ -1, -1, -1 })
+	if (sector.observerPos != Position{ -1, -1, -1 })
 	{
-		Position posDiff = toCheck - _eventVisibilityObserverPos;
+		Position posDiff = toCheck - sector.observerPos;
 		//Is toCheck within the arc as defined by the two tangent points?
-		return (!(-_eventVisibilitySectorL.x * posDiff.y + _eventVisibilitySectorL.y * posDiff.x > 0) &&
-			(-_eventVisibilitySectorR.x * posDiff.y + _eventVisibilitySectorR.y * posDiff.x > 0));
+		return (!(-sector.left.x * posDiff.y + sector.left.y * posDiff.x > 0) &&
+			(-sector.right.x * posDiff.y + sector.right.y * posDiff.x > 0));
 	}
 	else
 	{
@@ -1449,20 +1680,35 @@ inline bool TileEngine::inEventVisibilitySector(const Position &toCheck) const
 */
 bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos, const int eventRadius)
 {
-	size_t oldNumVisibleUnits = unit->getUnitsSpottedThisTurn().size();
+	FOVUpdate update;
+	findUnitsInFOV(unit, eventPos, eventRadius, update);
+	return applyUnitsInFOV(unit, update);
+}
+
+/**
+* Finds which units are in sight of a soldier, in a narrow arc around a given event position.
+* Only reads the battle, so it can run on worker threads for many units at once.
+* @param unit Unit to check line of sight of.
+* @param eventPos The centre of the event which necessitated the FOV update. Used to optimize which tiles to update.
+* @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
+* @param update Receives the units checked and whether they are seen.
+*/
+void TileEngine::findUnitsInFOV(BattleUnit* unit, const Position eventPos, const int eventRadius, FOVUpdate &update)
+{
 	bool useTurretDirection = false;
 	if (Options::strafe && (unit->getTurretType() > -1)) {
 		useTurretDirection = true;
 	}
 
 	if (unit->isOut())
-		return false;
+		return;
 
 	Position posSelf = unit->getPosition();
-	if (setupEventVisibilitySector(posSelf, eventPos, eventRadius))
+	EventVisibilitySector sector;
+	if (setupEventVisibilitySector(sector, posSelf, eventPos, eventRadius))
 	{
 		//Asked to do a full check. Or the event is overlapping our tile. Better check everything.
-		unit->clearVisibleUnits();
+		update.clearUnits = true;
 	}
 
 	//Loop through all units specified and figure out which ones we can actually see.
@@ -1478,49 +1724,80 @@ bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos,
 				{
 					Position posToCheck = posOther + Position(x, y, 0);
 					//If we can now find any unit within the arc defined by the event tangent points, its visibility may have been affected by the event.
-					if (inEventVisibilitySector(posToCheck))
+					if (inEventVisibilitySector(sector, posToCheck))
 					{
 						if (!unit->checkViewSector(posToCheck, useTurretDirection))
 						{
 							//Unit within arc, but not in view sector. If it just walked out we need to remove it.
-							unit->removeFromVisibleUnits(bu);
+							update.units.push_back(std::make_pair(bu, false));
 						}
 						else if (visible(unit, _save->getTile(posToCheck))) // (distance is checked here)
 						{
 							//Unit (or part thereof) visible to one or more eyes of this unit.
-							if (unit->getFaction() == FACTION_PLAYER)
-							{
-								bu->setVisible(true);
-							}
-							if ((( bu->getFaction() == FACTION_HOSTILE && unit->getFaction() == FACTION_PLAYER )
-								|| ( bu->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE ))
-								&& !unit->hasVisibleUnit(bu))
-							{
-								unit->addToVisibleUnits(bu);
-								unit->addToVisibleTiles(bu->getTile());
-							}
-
-							if (unit->getFaction() != bu->getFaction())
-							{
-								bu->setTurnsSinceSpottedByFaction(unit->getFaction(), 0);
-								bu->setTurnsLeftSpottedForSnipersByFaction(
-									unit->getFaction(),
-									std::max(unit->getSpotterDuration(), bu->getTurnsLeftSpottedForSnipersByFaction(unit->getFaction()))
-								); // defaults to 0 = no information given to snipers
-							}
-
+							update.units.push_back(std::make_pair(bu, true));
 							x = y = sizeOther; //If a unit's tile is visible there's no need to check the others: break the loops.
 						}
 						else
 						{
 							//Within arc, but not visible. Need to check to see if whatever happened at eventPos blocked a previously seen unit.
-							unit->removeFromVisibleUnits(bu);
+							update.units.push_back(std::make_pair(bu, false));
 						}
 					}
 				}
 			}
 		}
 	}
+}
+
+/**
+* Updates the visible units of a soldier with what findUnitsInFOV found.
+* @param unit Unit to update.
+* @param update Units checked by findUnitsInFOV.
+* @return True when new aliens are spotted.
+*/
+bool TileEngine::applyUnitsInFOV(BattleUnit* unit, const FOVUpdate &update)
+{
+	size_t oldNumVisibleUnits = unit->getUnitsSpottedThisTurn().size();
+	bool becameVisible = false;
+	if (update.clearUnits)
+	{
+		unit->clearVisibleUnits();
+	}
+
+	for (auto& pair : update.units)
+	{
+		BattleUnit *bu = pair.first;
+		if (!pair.second)
+		{
+			unit->removeFromVisibleUnits(bu);
+			continue;
+		}
+		if (unit->getFaction() == FACTION_PLAYER && !bu->getVisible())
+		{
+			bu->setVisible(true);
+			becameVisible = true;
+		}
+		if ((( bu->getFaction() == FACTION_HOSTILE && unit->getFaction() == FACTION_PLAYER )
+			|| ( bu->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE ))
+			&& !unit->hasVisibleUnit(bu))
+		{
+			unit->addToVisibleUnits(bu);
+			unit->addToVisibleTiles(bu->getTile());
+		}
+
+		if (unit->getFaction() != bu->getFaction())
+		{
+			bu->setTurnsSinceSpottedByFaction(unit->getFaction(), 0);
+			bu->setTurnsLeftSpottedForSnipersByFaction(
+				unit->getFaction(),
+				std::max(unit->getSpotterDuration(), bu->getTurnsLeftSpottedForSnipersByFaction(unit->getFaction()))
+			); // defaults to 0 = no information given to snipers
+		}
+	}
+	if (becameVisible || unit->getUnitsSpottedThisTurn().size() != oldNumVisibleUnits)
+	{
+		_save->getPathfinding()->invalidateReachable(); // known units block paths
+	}
 	// we only react when there are at least the same amount of visible units as before AND the checksum is different
 	// this way we stop if there are the same amount of visible units, but a different unit is seen
 	// or we stop if there are more visible units seen
@@ -1540,6 +1817,21 @@ bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos,
 * @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
 */
 void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius)
+{
+	FOVUpdate update;
+	findTilesInFOV(unit, eventPos, eventRadius, update);
+	applyTilesInFOV(unit, update);
+}
+
+/**
+* Finds the tiles in sight of a player controlled soldier, see calculateTilesInFOV.
+* Only reads the battle, so it can run on worker threads for many units at once.
+* @param unit Unit to check line of sight of.
+* @param eventPos The centre of the event which necessitated the FOV update. Used to optimize which tiles to update.
+* @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
+* @param update Receives the tiles in sight.
+*/
+void TileEngine::findTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, FOVUpdate &update)
 {
 	bool useTurretDirection = false;
 	bool skipNarrowArcTest = false;
@@ -1559,17 +1851,31 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 	}
 	else if (unit->isOut())
 	{
-		unit->clearVisibleTiles();
+		update.clearTiles = true;
 		return;
 	}
 	Position posSelf = unit->getPosition();
-	if (setupEventVisibilitySector(posSelf, eventPos, eventRadius))
+	EventVisibilitySector sector;
+	if (setupEventVisibilitySector(sector, posSelf, eventPos, eventRadius))
 	{
 		//Asked to do a full check. Or unit within event. Should update all.
-		unit->clearVisibleTiles();
+		update.clearTiles = true;
 		skipNarrowArcTest = true;
 	}
 
+	//Each tile is reported once, stamp the tiles already seen by this search.
+	auto& reached = fovScratch;
+	if (reached.stamp.size() < (size_t)_save->getMapSizeXYZ())
+	{
+		reached.stamp.assign(_save->getMapSizeXYZ(), 0);
+		reached.epoch = 0;
+	}
+	if (++reached.epoch == 0)
+	{
+		std::fill(reached.stamp.begin(), reached.stamp.end(), 0);
+		reached.epoch = 1;
+	}
+
 	//Only recalculate bresenham lines to tiles that are at the event or further away.
 	const int distanceSqrMin = skipNarrowArcTest ? 0 : std::max(Position::distance2dSq(posSelf, eventPos) - eventRadius * eventRadius, 0);
 
@@ -1610,7 +1916,7 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 				posTest.x = posSelf.x + signX[direction] * (swap ? y : x);
 				posTest.y = posSelf.y + signY[direction] * (swap ? x : y);
 				//Only continue if the column of tiles at (x,y) is within the narrow arc of interest (if enabled)
-				if (inEventVisibilitySector(posTest))
+				if (inEventVisibilitySector(sector, posTest))
 				{
 					for (int z = 0; z < _save->getMapSizeZ(); z++)
 					{
@@ -1638,17 +1944,11 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 									{
 										//Add tiles to the visible list only once. BUT we still need to calculate the whole trajectory as
 										// this bresenham line's period might be different from the one that originally revealed the tile.
-										if (!unit->hasVisibleTile(_save->getTile(posVisited)))
+										int index = _save->getTileIndex(posVisited);
+										if (reached.stamp[index] != reached.epoch)
 										{
-											unit->addToVisibleTiles(_save->getTile(posVisited));
-											_save->getTile(posVisited)->setVisible(+1);
-											_save->getTile(posVisited)->setDiscovered(true, O_FLOOR);
-
-											// walls to the east or south of a visible tile, we see that too
-											Tile* t = _save->getTile(Position(posVisited.x + 1, posVisited.y, posVisited.z));
-											if (t) t->setDiscovered(true, O_WESTWALL);
-											t = _save->getTile(Position(posVisited.x, posVisited.y + 1, posVisited.z));
-											if (t) t->setDiscovered(true, O_NORTHWALL);
+											reached.stamp[index] = reached.epoch;
+											update.tiles.push_back(_save->getTile(index));
 										}
 									}
 								}
@@ -1661,6 +1961,35 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 	}
 }
 
+/**
+* Reveals the tiles found by findTilesInFOV to a soldier.
+* @param unit Unit to update.
+* @param update Tiles found by findTilesInFOV.
+*/
+void TileEngine::applyTilesInFOV(BattleUnit *unit, const FOVUpdate &update)
+{
+	if (update.clearTiles)
+	{
+		unit->clearVisibleTiles();
+	}
+	for (auto* tile : update.tiles)
+	{
+		if (!unit->hasVisibleTile(tile))
+		{
+			unit->addToVisibleTiles(tile);
+			tile->setVisible(+1);
+			tile->setDiscovered(true, O_FLOOR);
+
+			// walls to the east or south of a visible tile, we see that too
+			Position posVisited = tile->getPosition();
+			Tile* t = _save->getTile(Position(posVisited.x + 1, posVisited.y, posVisited.z));
+			if (t) t->setDiscovered(true, O_WESTWALL);
+			t = _save->getTile(Position(posVisited.x, posVisited.y + 1, posVisited.z));
+			if (t) t->setDiscovered(true, O_NORTHWALL);
+		}
+	}
+}
+
 /**
 * Recalculates line of sight of a soldier.
 * @param unit Unit to check line of sight of.
@@ -1670,6 +1999,7 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 */
 bool TileEngine::calculateFOV(BattleUnit *unit, bool doTileRecalc, bool doUnitRecalc)
 {
+	TRACE_ZONE("TileEngine::calculateFOV");
 	//Force a full FOV recheck for this unit.
 	if (doTileRecalc) calculateTilesInFOV(unit);
 	return doUnitRecalc ? calculateUnitsInFOV(unit) : false;
@@ -1882,6 +2212,13 @@ bool TileEngine::visible(BattleUnit *currentUnit, Tile *tile)
 		}
 	}
 
+	const int tileIndex = _save->getTileIndex(tile->getPosition());
+	const int cached = _visibilityCache.get(currentUnit->getId(), tileIndex);
+	if (cached != -1)
+	{
+		return cached;
+	}
+
 	const auto [visibleDistanceMaxVoxel, visibleDistanceUnitMaxTile] = getVisibleDistanceMaxHelper(this, tile, currentUnit, tile->getUnit());
 
 	Position originVoxel = getSightOriginVoxel(currentUnit);
@@ -1908,6 +2245,7 @@ bool TileEngine::visible(BattleUnit *currentUnit, Tile *tile)
 		worker.execute(currentUnit->getArmor()->getScript<ModScript::VisibilityUnit>(), arg);
 		unitSeen = 0 < arg.getFirst();
 	}
+	_visibilityCache.set(currentUnit->getId(), tileIndex, unitSeen);
 	return unitSeen;
 }
 
@@ -2453,6 +2791,7 @@ bool TileEngine::canTargetTile(Position *originVoxel, Tile *tile, int part, Posi
  */
 void TileEngine::calculateFOV(Position position, int eventRadius, const bool updateTiles, const bool appendToTileVisibility)
 {
+	TRACE_ZONE("TileEngine::calculateFOV");
 	int updateRadius;
 	if (eventRadius == -1)
 	{
@@ -2465,21 +2804,69 @@ void TileEngine::calculateFOV(Position position, int eventRadius, const bool upd
 		updateRadius = getMaxViewDistance() + (eventRadius > 0 ? eventRadius : 0);
 		updateRadius *= updateRadius;
 	}
+	invalidateVisibility();
+	std::vector<BattleUnit*> observers;
 	for (auto* bu : *_save->getUnits())
 	{
 		if (Position::distance2dSq(position, bu->getPosition()) <= updateRadius) //could this unit have observed the event?
 		{
-			if (updateTiles)
+			observers.push_back(bu);
+		}
+	}
+	calculateFOVOfUnits(observers, position, eventRadius, updateTiles, appendToTileVisibility);
+}
+
+/**
+ * Updates line of sight of several units for the same event.
+ * The lines of sight are traced on the worker threads, then the results
+ * are applied to the units and tiles one unit at a time, in the given order,
+ * so the outcome is the same as updating the units one after the other.
+ * Mod visibility scripts are not made to run concurrently (they can log, for one),
+ * so when any of the units has one, everything is traced on this thread.
+ * @param units Units to update.
+ * @param eventPos Position of the event, or invalid for a full update.
+ * @param eventRadius Radius of circle big enough to encompass the event.
+ * @param updateTiles true to do an update of visible tiles.
+ * @param appendToTileVisibility true to append only new tiles and skip previously seen ones.
+ */
+void TileEngine::calculateFOVOfUnits(const std::vector<BattleUnit*> &units, Position eventPos, int eventRadius, bool updateTiles, bool appendToTileVisibility)
+{
+	std::vector<FOVUpdate> updates(units.size());
+	auto find = [&](int i)
+	{
+		if (updateTiles)
+		{
+			findTilesInFOV(units[i], eventPos, eventRadius, updates[i]);
+		}
+		findUnitsInFOV(units[i], eventPos, eventRadius, updates[i]);
+	};
+	bool scripted = std::any_of(units.begin(), units.end(), [](const BattleUnit *bu)
+	{
+		return bu->getArmor()->getScript<ModScript::VisibilityUnit>().hasCode();
+	});
+	if (scripted)
+	{
+		for (int i = 0; i < (int)units.size(); ++i)
+		{
+			find(i);
+		}
+	}
+	else
+	{
+		ThreadPool::parallelFor((int)units.size(), find);
+	}
+
+	for (size_t i = 0; i < units.size(); ++i)
+	{
+		if (updateTiles)
+		{
+			if (!appendToTileVisibility)
 			{
-				if (!appendToTileVisibility)
-				{
-					bu->clearVisibleTiles();
-				}
-				calculateTilesInFOV(bu, position, eventRadius);
+				units[i]->clearVisibleTiles();
 			}
-
-			calculateUnitsInFOV(bu, position, eventRadius);
+			applyTilesInFOV(units[i], updates[i]);
 		}
+		applyUnitsInFOV(units[i], updates[i]);
 	}
 }
 
@@ -2540,6 +2927,30 @@ bool TileEngine::checkReactionFire(BattleUnit *unit, const BattleAction &origina
 	return result;
 }
 
+/**
+ * Counts the units that could react to this unit, without taking any reaction shots.
+ * Used where there is no BattlescapeGame to resolve the shots (e.g. the headless benchmark).
+ * @param unit The unit to check for potential reactors to.
+ * @return Number of units that would attempt a reaction.
+ */
+int TileEngine::countReactionFireSpotters(BattleUnit *unit)
+{
+	if (_save->isPreview() || unit->getFaction() != _save->getSide() || unit->getTile() == 0)
+	{
+		return 0;
+	}
+
+	int count = 0;
+	for (auto& rs : getSpottingUnits(unit))
+	{
+		if (rs.attackType != BA_NONE)
+		{
+			++count;
+		}
+	}
+	return count;
+}
+
 /**
  * Creates a vector of units that can spot this unit.
  * @param unit The unit to check for spotters of.
@@ -2601,24 +3012,30 @@ std::vector<TileEngine::ReactionScore> TileEngine::getSpottingUnits(BattleUnit*
 
 					// can actually see the target Tile, or we got hit
 				if ((bu->checkViewSector(unit->getPosition()) || gotHit) &&
+					// can actually see the unit, usually already known from the field of view update
+					visible(bu, tile) &&
 					// can actually target the unit
-					canTargetUnit(&originVoxel, tile, &targetVoxel, bu, false) &&
-					// can actually see the unit
-					visible(bu, tile))
+					canTargetUnit(&originVoxel, tile, &targetVoxel, bu, false))
 				{
-					if (bu->getFaction() == FACTION_PLAYER)
+					if (bu->getFaction() == FACTION_PLAYER && !unit->getVisible())
 					{
 						unit->setVisible(true);
+						_save->getPathfinding()->invalidateReachable();
 					}
+					size_t oldNumSpotted = bu->getUnitsSpottedThisTurn().size();
 					bu->addToVisibleUnits(unit);
+					if (bu->getUnitsSpottedThisTurn().size() != oldNumSpotted)
+					{
+						_save->getPathfinding()->invalidateReachable();
+					}
 					ReactionScore rs = determineReactionType(bu, unit);
 					if (rs.attackType != BA_NONE)
 					{
-						int reactionFireThreshold = _save->getBattleGame()->getMod()->getReactionFireThreshold(bu->getFaction());
+						int reactionFireThreshold = _save->getMod()->getReactionFireThreshold(bu->getFaction());
 						if (reactionFireThreshold > 0)
 						{
 							BattleItem *weapon = rs.weapon;
-							int accuracy = BattleUnit::getFiringAccuracy(BattleActionAttack::GetBeforeShoot(rs.attackType, rs.unit, weapon), _save->getBattleGame()->getMod());
+							int accuracy = BattleUnit::getFiringAccuracy(BattleActionAttack::GetBeforeShoot(rs.attackType, rs.unit, weapon), _save->getMod());
 							int distanceSq = unit->distance3dToUnitSq(bu);
 							int distance = (int)std::ceil(sqrt(float(distanceSq)));
 
@@ -2910,6 +3327,7 @@ int TileEngine::hitTile(Tile* tile, int damage, const RuleDamageType* type)
 				tile->setSmoke(RNG::generate(7, 15)); // for SmokeThreshold == 0
 			else
 				tile->setSmoke(RNG::generate(7, 15) * (damage - type->SmokeThreshold) / type->SmokeThreshold);
+			_save->getPathfinding()->invalidateReachable(); // smoke and fire change move costs, not connectivity
 			return 1;
 		}
 	}
@@ -2924,6 +3342,7 @@ int TileEngine::hitTile(Tile* tile, int damage, const RuleDamageType* type)
 				else
 					tile->setFire(tile->getFuel() * (damage - type->FireThreshold) / type->FireThreshold + 1);
 				tile->setSmoke(std::max(1, std::min(15 - (tile->getFlammability() / 10), 12)));
+				_save->getPathfinding()->invalidateReachable();
 				return 2;
 			}
 		}
@@ -3266,6 +3685,11 @@ void TileEngine::hit(BattleActionAttack attack, Position center, int power, cons
 			{
 				_save->addDestroyedObjective();
 			}
+			if (terrainChanged)
+			{
+				_save->getPathfinding()->invalidateTerrain(tilePos);
+				updateVoxelGrid(tilePos);
+			}
 		}
 	}
 	else if (part == V_UNIT)
@@ -3329,13 +3753,26 @@ void TileEngine::hit(BattleActionAttack attack, Position center, int power, cons
  */
 void TileEngine::explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack)
 {
+	explodeBatch({ Explosion{ attack, center, power, type, maxRadius, rangeAtack } });
+}
+
+/**
+ * Traces the rays of an explosion that leave its center at one vertical angle.
+ * Only reads the battle, so rays can be traced on worker threads.
+ * @param explosion The explosion.
+ * @param fi Vertical angle of the rays, in degrees.
+ * @param steps Receives every tile the rays reach, in order, with the power left there.
+ */
+void TileEngine::traceExplosionRays(const Explosion &explosion, int fi, std::vector<std::pair<Tile*, int> > &steps)
+{
+	const RuleDamageType *type = explosion.type;
+	const Position center = explosion.center;
 	const Position centetTile = center.toTile();
+	const int maxRadius = explosion.maxRadius;
+	int power = explosion.power;
 	int hitSide = 0;
 	int diagonalWall = 0;
 	int power_;
-	std::map<Tile*, int> tilesAffected;
-	std::vector<BattleItem*> toRemove;
-	std::pair<std::map<Tile*, int>::iterator, bool> ret;
 
 	if (type->FireBlastCalc)
 	{
@@ -3368,168 +3805,225 @@ void TileEngine::explode(BattleActionAttack attack, Position center, int power,
 			hitSide = (center.x % 16 + center.y % 16 - 15) > 0 ? 1 : -1;
 	}
 
-	for (int fi = -90; fi <= 90; fi += 5)
+	// raytrace every 3 degrees makes sure we cover all tiles in a circle.
+	for (int te = 0; te <= 360; te += 3)
 	{
-		// raytrace every 3 degrees makes sure we cover all tiles in a circle.
-		for (int te = 0; te <= 360; te += 3)
+		double cos_te = cos(Deg2Rad(te));
+		double sin_te = sin(Deg2Rad(te));
+		double sin_fi = sin(Deg2Rad(fi));
+		double cos_fi = cos(Deg2Rad(fi));
+
+		origin = _save->getTile(centetTile);
+		dest = origin;
+		double l = 0;
+		int tileX, tileY, tileZ;
+		power_ = power;
+		while (power_ > 0 && l <= maxRadius)
 		{
-			double cos_te = cos(Deg2Rad(te));
-			double sin_te = sin(Deg2Rad(te));
-			double sin_fi = sin(Deg2Rad(fi));
-			double cos_fi = cos(Deg2Rad(fi));
+			steps.push_back(std::make_pair(dest, power_));
+
+			l += 1.0;
+
+			tileX = int(floor(centetTile.x + 0.5 + l * sin_te * cos_fi));
+			tileY = int(floor(centetTile.y + 0.5 + l * cos_te * cos_fi));
+			tileZ = int(floor(centetTile.z + 0.5 + l * sin_fi));
+
+			origin = dest;
+			dest = _save->getTile(Position(tileX, tileY, tileZ));
+
+			if (!dest) break; // out of map!
+
+			// blockage by terrain is deducted from the explosion power
+			power_ -= type->RadiusReduction; // explosive damage decreases by 10 per tile
+			if (origin->getPosition().z != tileZ)
+				power_ -= vertdec; //3d explosion factor
 
-			origin = _save->getTile(centetTile);
-			dest = origin;
-			double l = 0;
-			int tileX, tileY, tileZ;
-			power_ = power;
-			while (power_ > 0 && l <= maxRadius)
+			if (type->FireBlastCalc)
 			{
-				if (power_ > 0)
+				int dir;
+				Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
+				if (dir != -1 && dir %2) power_ -= 0.5f * type->RadiusReduction; // diagonal movement costs an extra 50% for fire.
+			}
+			if (l > 0.5) {
+				if ( l > 1.5)
 				{
-					ret = tilesAffected.insert(std::make_pair(dest, 0)); // check if we had this tile already affected
-
-					const int tileDmg = type->getTileFinalDamage(power_);
-					if (tileDmg > ret.first->second)
+					power_ -= verticalBlockage(origin, dest, type->ResistType, false) * 2;
+					power_ -= horizontalBlockage(origin, dest, type->ResistType, false) * 2;
+				}
+				else //tricky bigwall deflection /Volutar
+				{
+					bool skipObject = diagonalWall == 0;
+					if (diagonalWall == Pathfinding::BIGWALLNESW) // --
 					{
-						ret.first->second = tileDmg;
+						if (hitSide<0 && te >= 135 && te < 315)
+							skipObject = true;
+						if (hitSide>0 && ( te < 135 || te > 315))
+							skipObject = true;
 					}
-					if (ret.second)
+					if (diagonalWall == Pathfinding::BIGWALLNWSE) // |
 					{
-						const int damage = type->getRandomDamage(power_);
-						BattleUnit *bu = dest->getOverlappingUnit(_save);
-
-						toRemove.clear();
-						if (bu)
-						{
-							if (dest->getPosition() == centetTile)
-							{
-								// direct hit, similar to ground zero but AI will remember attacker, done for compatibility
-								hitUnit(attack, bu, Position(0, 0, 0), damage, type, rangeAtack);
-							}
-							else if (
-									(
-										Position::distance2dSq(dest->getPosition(), centetTile) < 4
-										&& dest->getPosition().z == centetTile.z
-									)
-									|| dest->getPosition().z > centetTile.z
-								)
-							{
-								// ground zero effect is in effect, or unit is above explosion
-								hitUnit(attack, bu, Position(0, 0, -1), damage, type, rangeAtack);
-							}
-							else
-							{
-								// directional damage relative to explosion position.
-								// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
-								hitUnit(attack, bu, centetTile + Position(0, 0, 5) - dest->getPosition(), damage, type, rangeAtack);
-							}
-
-							// Affect all items and units in inventory
-							const int itemDamage = bu->getOverKillDamage();
-							if (itemDamage > 0)
-							{
-								for (auto* bi : *bu->getInventory())
-								{
-									if (!hitUnit(attack, bi->getUnit(), Position(0, 0, 0), itemDamage, type, rangeAtack) && type->getItemFinalDamage(itemDamage) > bi->getRules()->getArmor())
-									{
-										toRemove.push_back(bi);
-									}
-								}
-							}
-						}
-						// Affect all items and units on ground
-						for (auto* bi : *dest->getInventory())
-						{
-							if (!hitUnit(attack, bi->getUnit(), Position(0, 0, 0), damage, type) && type->getItemFinalDamage(damage) > bi->getRules()->getArmor())
-							{
-								toRemove.push_back(bi);
-							}
-						}
-						for (auto* bi : toRemove)
-						{
-							_save->removeItem(bi);
-						}
-
-						hitTile(dest, damage, type);
+						if (hitSide>0 && te >= 45 && te < 225)
+							skipObject = true;
+						if (hitSide<0 && ( te < 45 || te > 225))
+							skipObject = true;
 					}
+					power_ -= verticalBlockage(origin, dest, type->ResistType, skipObject) * 2;
+					power_ -= horizontalBlockage(origin, dest, type->ResistType, skipObject) * 2;
+
 				}
+			}
+		}
+	}
+}
 
-				l += 1.0;
+/**
+ * Handles several explosions happening at the same time, like a chain of terrain explosions.
+ * The explosions are resolved one after another, in the given order, exactly as separate
+ * explode() calls would: the rays of each explosion are traced against the terrain left
+ * by the previous ones, on the worker threads, one task per vertical angle. Damage is then
+ * applied on this thread in the order of the rays, so the dice are rolled the same way on every machine.
+ * Lighting and line of sight are updated once for the whole batch.
+ * @param explosions Explosions to resolve.
+ */
+void TileEngine::explodeBatch(const std::vector<Explosion> &explosions)
+{
+	if (explosions.empty())
+	{
+		return;
+	}
+
+	const int rows = 180 / 5 + 1; // from -90 to 90 degrees, every 5 degrees
+	std::vector<std::vector<std::pair<Tile*, int> > > steps(rows);
 
-				tileX = int(floor(centetTile.x + 0.5 + l * sin_te * cos_fi));
-				tileY = int(floor(centetTile.y + 0.5 + l * cos_te * cos_fi));
-				tileZ = int(floor(centetTile.z + 0.5 + l * sin_fi));
+	Position low = explosions.front().center.toTile();
+	Position high = low;
+	int maxRadius = 0;
+	for (size_t e = 0; e < explosions.size(); ++e)
+	{
+		const auto& attack = explosions[e].attack;
+		const auto* type = explosions[e].type;
+		const bool rangeAtack = explosions[e].rangeAtack;
+		const Position centetTile = explosions[e].center.toTile();
+		std::map<Tile*, int> tilesAffected;
+		std::vector<BattleItem*> toRemove;
+		std::pair<std::map<Tile*, int>::iterator, bool> ret;
 
-				origin = dest;
-				dest = _save->getTile(Position(tileX, tileY, tileZ));
+		ThreadPool::parallelFor(rows, [&](int row)
+		{
+			steps[row].clear();
+			traceExplosionRays(explosions[e], -90 + row * 5, steps[row]);
+		});
 
-				if (!dest) break; // out of map!
+		for (int row = 0; row < rows; ++row)
+		{
+			for (auto& step : steps[row])
+			{
+				Tile *dest = step.first;
+				const int power_ = step.second;
 
-				// blockage by terrain is deducted from the explosion power
-				power_ -= type->RadiusReduction; // explosive damage decreases by 10 per tile
-				if (origin->getPosition().z != tileZ)
-					power_ -= vertdec; //3d explosion factor
+				ret = tilesAffected.insert(std::make_pair(dest, 0)); // check if we had this tile already affected
 
-				if (type->FireBlastCalc)
+				const int tileDmg = type->getTileFinalDamage(power_);
+				if (tileDmg > ret.first->second)
 				{
-					int dir;
-					Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
-					if (dir != -1 && dir %2) power_ -= 0.5f * type->RadiusReduction; // diagonal movement costs an extra 50% for fire.
+					ret.first->second = tileDmg;
 				}
-				if (l > 0.5) {
-					if ( l > 1.5)
-					{
-						power_ -= verticalBlockage(origin, dest, type->ResistType, false) * 2;
-						power_ -= horizontalBlockage(origin, dest, type->ResistType, false) * 2;
-					}
-					else //tricky bigwall deflection /Volutar
+				if (ret.second)
+				{
+					const int damage = type->getRandomDamage(power_);
+					BattleUnit *bu = dest->getOverlappingUnit(_save);
+
+					toRemove.clear();
+					if (bu)
 					{
-						bool skipObject = diagonalWall == 0;
-						if (diagonalWall == Pathfinding::BIGWALLNESW) // --
+						if (dest->getPosition() == centetTile)
+						{
+							// direct hit, similar to ground zero but AI will remember attacker, done for compatibility
+							hitUnit(attack, bu, Position(0, 0, 0), damage, type, rangeAtack);
+						}
+						else if (
+								(
+									Position::distance2dSq(dest->getPosition(), centetTile) < 4
+									&& dest->getPosition().z == centetTile.z
+								)
+								|| dest->getPosition().z > centetTile.z
+							)
 						{
-							if (hitSide<0 && te >= 135 && te < 315)
-								skipObject = true;
-							if (hitSide>0 && ( te < 135 || te > 315))
-								skipObject = true;
+							// ground zero effect is in effect, or unit is above explosion
+							hitUnit(attack, bu, Position(0, 0, -1), damage, type, rangeAtack);
 						}
-						if (diagonalWall == Pathfinding::BIGWALLNWSE) // |
+						else
 						{
-							if (hitSide>0 && te >= 45 && te < 225)
-								skipObject = true;
-							if (hitSide<0 && ( te < 45 || te > 225))
-								skipObject = true;
+							// directional damage relative to explosion position.
+							// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
+							hitUnit(attack, bu, centetTile + Position(0, 0, 5) - dest->getPosition(), damage, type, rangeAtack);
 						}
-						power_ -= verticalBlockage(origin, dest, type->ResistType, skipObject) * 2;
-						power_ -= horizontalBlockage(origin, dest, type->ResistType, skipObject) * 2;
 
+						// Affect all items and units in inventory
+						const int itemDamage = bu->getOverKillDamage();
+						if (itemDamage > 0)
+						{
+							for (auto* bi : *bu->getInventory())
+							{
+								if (!hitUnit(attack, bi->getUnit(), Position(0, 0, 0), itemDamage, type, rangeAtack) && type->getItemFinalDamage(itemDamage) > bi->getRules()->getArmor())
+								{
+									toRemove.push_back(bi);
+								}
+							}
+						}
+					}
+					// Affect all items and units on ground
+					for (auto* bi : *dest->getInventory())
+					{
+						if (!hitUnit(attack, bi->getUnit(), Position(0, 0, 0), damage, type) && type->getItemFinalDamage(damage) > bi->getRules()->getArmor())
+						{
+							toRemove.push_back(bi);
+						}
+					}
+					for (auto* bi : toRemove)
+					{
+						_save->removeItem(bi);
 					}
+
+					hitTile(dest, damage, type);
 				}
 			}
 		}
-	}
 
-	// now detonate the tiles affected by explosion
-	if (type->ToTile > 0.0f)
-	{
-		for (auto& pair : tilesAffected)
+		// now detonate the tiles affected by explosion
+		if (type->ToTile > 0.0f)
 		{
-			if (detonate(pair.first, pair.second))
+			for (auto& pair : tilesAffected)
 			{
-				_save->addDestroyedObjective();
+				if (detonate(pair.first, pair.second))
+				{
+					_save->addDestroyedObjective();
+				}
+				applyGravity(pair.first);
+				Tile *j = _save->getTile(pair.first->getPosition() + Position(0,0,1));
+				if (j)
+					applyGravity(j);
 			}
-			applyGravity(pair.first);
-			Tile *j = _save->getTile(pair.first->getPosition() + Position(0,0,1));
-			if (j)
-				applyGravity(j);
 		}
+
+		low = Position(std::min(low.x, centetTile.x), std::min(low.y, centetTile.y), std::min(low.z, centetTile.z));
+		high = Position(std::max(high.x, centetTile.x), std::max(high.y, centetTile.y), std::max(high.z, centetTile.z));
+		maxRadius = std::max(maxRadius, explosions[e].maxRadius);
 	}
-	calculateLighting(LL_AMBIENT, centetTile, maxRadius + 1, true); // roofs could have been destroyed and fires could have been started
-	calculateFOV(centetTile, maxRadius + 1, true, true);
-	if (attack.attacker && Position::distance2d(centetTile, attack.attacker->getPosition()) > maxRadius + 1)
+
+	// one update around all the explosions
+	const Position centetTile = Position((low.x + high.x) / 2, (low.y + high.y) / 2, (low.z + high.z) / 2);
+	const int spread = std::max({ high.x - centetTile.x, high.y - centetTile.y, high.z - centetTile.z });
+	calculateLighting(LL_AMBIENT, centetTile, spread + maxRadius + 1, true); // roofs could have been destroyed and fires could have been started
+	calculateFOV(centetTile, spread + maxRadius + 1, true, true);
+	for (const auto& explosion : explosions)
 	{
-		// unit is away from blast but its visibility can be affected by scripts.
-		calculateFOV(centetTile, 1, false);
+		const Position explosionTile = explosion.center.toTile();
+		if (explosion.attack.attacker && Position::distance2d(explosionTile, explosion.attack.attacker->getPosition()) > explosion.maxRadius + 1)
+		{
+			// unit is away from blast but its visibility can be affected by scripts.
+			calculateFOV(explosionTile, 1, false);
+		}
 	}
 }
 
@@ -3628,11 +4122,14 @@ bool TileEngine::detonate(Tile* tile, int explosive)
 			{
 				tiles[i]->setFire(fuel);
 				tiles[i]->setSmoke(Clamp(15 - (fireProof / 10), 1, 12));
+				_save->getPathfinding()->invalidateReachable();
 			}
 		}
 		// add some smoke if tile was destroyed and not set on fire
 		if (destroyed)
 		{
+			_save->getPathfinding()->invalidateTerrain(tiles[i]->getPosition());
+			updateVoxelGrid(tiles[i]->getPosition());
 			if (tiles[i]->getFire() && !tiles[i]->getMapData(O_FLOOR) && !tiles[i]->getMapData(O_OBJECT))
 			{
 				tiles[i]->setFire(0);// if the object set the floor on fire, and the floor was subsequently destroyed, the fire needs to go out
@@ -4169,7 +4666,7 @@ int TileEngine::unitOpensDoor(BattleUnit *unit, bool rClick, int dir)
 				tile = _save->getTile(unit->getPosition() + Position(x,y,z) + pair.first);
 				if (tile)
 				{
-					door = tile->openDoor(pair.second, unit, _save->getBattleGame()->getReservedAction(), rClick);
+					door = tile->openDoor(pair.second, unit, _save->getTUReserved(), rClick);
 					if (door != -1)
 					{
 						part = pair.second;
@@ -4208,7 +4705,10 @@ int TileEngine::unitOpensDoor(BattleUnit *unit, bool rClick, int dir)
 
 	if (door == 0 || door == 1)
 	{
-		if (_save->getBattleGame()->checkReservedTU(unit, TUCost, 0))
+		_save->getPathfinding()->invalidateTerrain(doorCentre, doorsOpened + 2);
+		updateVoxelGrid(doorCentre, doorsOpened + 1);
+		auto* battleGame = _save->getBattleGame();
+		if (!battleGame || battleGame->checkReservedTU(unit, TUCost, 0))
 		{
 			if (unit->spendTimeUnits(TUCost))
 			{
@@ -4294,7 +4794,12 @@ int TileEngine::closeUfoDoors()
 				continue;
 			}
 		}
-		doorsclosed += _save->getTile(i)->closeUfoDoor();
+		if (_save->getTile(i)->closeUfoDoor())
+		{
+			_save->getPathfinding()->invalidateTerrain(_save->getTile(i)->getPosition());
+			updateVoxelGrid(_save->getTile(i)->getPosition());
+			++doorsclosed;
+		}
 	}
 
 	return doorsclosed;
@@ -4534,10 +5039,10 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 	}
 	Position pos = voxel.toTile();
 	Tile *tile, *tileBelow;
-	if (_cacheTilePos == pos)
+	if (voxelCache.generation == _cacheGeneration && voxelCache.pos == pos)
 	{
-		tile = _cacheTile;
-		tileBelow = _cacheTileBelow;
+		tile = voxelCache.tile;
+		tileBelow = voxelCache.tileBelow;
 	}
 	else
 	{
@@ -4547,9 +5052,10 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 			return V_OUTOFBOUNDS; //not even cache
 		}
 		tileBelow = _save->getBelowTile(tile);
-		_cacheTilePos = pos;
-		_cacheTile = tile;
-		_cacheTileBelow = tileBelow;
+		voxelCache.generation = _cacheGeneration;
+		voxelCache.pos = pos;
+		voxelCache.tile = tile;
+		voxelCache.tileBelow = tileBelow;
  	}
 
 	if (tile->isVoid() && tile->getUnit() == 0 && (!tileBelow || tileBelow->getUnit() == 0))
@@ -4557,29 +5063,33 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 		return V_EMPTY;
 	}
 
-	if (tile->hasGravLiftFloor() && (voxel.z % 24 == 0 || voxel.z % 24 == 1))
+	// first we check terrain voxel data, not to allow 2x2 units stick through walls
+	// the merged grid tells if there is any terrain, the parts are only looked at to find which one
+	if (_voxelGrid.isTerrain(_save->getTileIndex(pos), voxel))
 	{
-		if (!(tileBelow && tileBelow->hasGravLiftFloor()))
+		if (tile->hasGravLiftFloor() && (voxel.z % 24 == 0 || voxel.z % 24 == 1))
 		{
-			return V_FLOOR;
+			if (!(tileBelow && tileBelow->hasGravLiftFloor()))
+			{
+				return V_FLOOR;
+			}
 		}
-	}
 
-	// first we check terrain voxel data, not to allow 2x2 units stick through walls
-	for (int i = V_FLOOR; i <= V_OBJECT; ++i)
-	{
-		TilePart tp = (TilePart)i;
-		MapData *mp = tile->getMapData(tp);
-		if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
-			continue;
-		if (mp != 0)
+		for (int i = V_FLOOR; i <= V_OBJECT; ++i)
 		{
-			int x = 15 - voxel.x%16;
-			int y = voxel.y%16;
-			int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
-			if (_voxelData->at(idx) & (1 << x))
+			TilePart tp = (TilePart)i;
+			MapData *mp = tile->getMapData(tp);
+			if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
+				continue;
+			if (mp != 0)
 			{
-				return (VoxelType)i;
+				int x = 15 - voxel.x%16;
+				int y = voxel.y%16;
+				int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
+				if (_voxelData->at(idx) & (1 << x))
+				{
+					return (VoxelType)i;
+				}
 			}
 		}
 	}
@@ -4627,11 +5137,37 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 	return V_EMPTY;
 }
 
+/**
+ * Rebuilds the terrain voxels around a position after tiles changed outside
+ * of a terrain lighting update. The tiles above are included for grav lifts.
+ * @param pos Center of the change.
+ * @param radius Number of tiles around the center.
+ */
+void TileEngine::updateVoxelGrid(Position pos, int radius)
+{
+	invalidateVisibility();
+	for (int x = pos.x - radius; x <= pos.x + radius; ++x)
+	{
+		for (int y = pos.y - radius; y <= pos.y + radius; ++y)
+		{
+			for (int z = pos.z; z <= pos.z + 1; ++z)
+			{
+				Tile *tile = _save->getTile(Position(x, y, z));
+				if (tile)
+				{
+					_voxelGrid.update(_save, tile);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Drops the tiles cached by voxelCheck, on every thread.
+ */
 void TileEngine::voxelCheckFlush()
 {
-	_cacheTilePos = invalid;
-	_cacheTile = 0;
-	_cacheTileBelow = 0;
+	_cacheGeneration = ++voxelCacheGenerations;
 }
 
 /**
@@ -4795,6 +5331,8 @@ bool TileEngine::psiAttack(BattleActionAttack attack, BattleUnit *victim)
 				}
 			}
 			victim->setMindControllerId(attack.attacker->getId());
+			_save->getPathfinding()->invalidateReachable(); // friends and foes block paths differently
+			invalidateVisibility(); // and friends are always seen
 			if (attack.weapon_item->getRules()->convertToCivilian() && victim->getOriginalFaction() == FACTION_HOSTILE)
 			{
 				victim->convertToFaction(FACTION_NEUTRAL);
@@ -5746,13 +6284,16 @@ bool TileEngine::validateThrow(BattleAction &action, Position originVoxel, Posit
  */
 void TileEngine::recalculateFOV()
 {
+	invalidateVisibility();
+	std::vector<BattleUnit*> observers;
 	for (auto* bu : *_save->getUnits())
 	{
 		if (bu->getTile() != 0)
 		{
-			calculateFOV(bu);
+			observers.push_back(bu);
 		}
 	}
+	calculateFOVOfUnits(observers, invalid, 0, true, true);
 }
 
 /**
@@ -17,11 +17,15 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <map>
+#include <utility>
 #include <vector>
 #include "Position.h"
 #include "BattlescapeGame.h"
 #include "../Mod/RuleItem.h"
 #include "../Mod/MapData.h"
+#include "VisibilityCache.h"
+#include "VoxelGrid.h"
 
 namespace OpenXcom
 {
@@ -76,6 +80,19 @@ public:
 		return 0.0f;
 	}
 
+	/**
+	 * Explosion waiting to be resolved with others by explodeBatch.
+	 */
+	struct Explosion
+	{
+		BattleActionAttack attack;
+		Position center;
+		int power;
+		const RuleDamageType *type;
+		int maxRadius;
+		bool rangeAtack;
+	};
+
 private:
 	/**
 	 * Helper class storing cached visibility blockage data.
@@ -115,9 +132,12 @@ private:
 	const RuleInventory *_inventorySlotGround;
 	constexpr static int heightFromCenter[11] = {0,-2,+2,-4,+4,-6,+6,-8,+8,-12,+12};
 	bool _personalLighting;
-	Tile *_cacheTile;
-	Tile *_cacheTileBelow;
-	Position _cacheTilePos;
+	/// Tag of the voxelCheck tile cache, changed by voxelCheckFlush.
+	unsigned _cacheGeneration;
+	/// Terrain voxels of the whole map.
+	VoxelGrid _voxelGrid;
+	/// Results of visible() since the battlefield last changed.
+	VisibilityCache _visibilityCache;
 	const int _maxViewDistance;        // 20 tiles by default
 	const int _maxViewDistanceSq;      // 20 * 20
 	const int _maxVoxelViewDistance;   // maxViewDistance * 16
@@ -125,26 +145,77 @@ private:
 	const int _maxStaticLightDistance;
 	const int _maxDynamicLightDistance;
 	const int _enhancedLighting;
-	Position _eventVisibilitySectorL, _eventVisibilitySectorR, _eventVisibilityObserverPos;
 	std::vector<BattleUnit*> _movingUnitPrev;
 	BattleUnit* _movingUnit = nullptr;
 
+	/// Light of one item or unit, with what it gives to every tile in its range.
+	struct LightSource
+	{
+		Position center;
+		int power = 0;
+		/// Light of the tiles in range, row by row and level by level, 0 where static light is brighter.
+		std::vector<Uint8> light;
+	};
+	/// Lights of the items lying on tiles, by tile index.
+	std::map<std::pair<int, int>, LightSource> _itemLights;
+	/// Lights of the units, by unit id and part of the unit.
+	std::map<std::pair<int, int>, LightSource> _unitLights;
+
+	/// Spreads light from a center to the tiles around it.
+	template<typename TargetFunc, typename LightFunc>
+	void propagateLight(MapSubset gs, Position center, int power, LightLayers layer, TargetFunc &&getTarget, LightFunc &&setLight) const;
 	/// Add light source.
 	void addLight(MapSubset gs, Position center, int power, LightLayers layer);
+	/// Gets the tiles a dynamic light source can reach.
+	MapSubset getLightArea(const LightSource &source) const;
+	/// Finds the light a dynamic light source gives to every tile in its range.
+	void traceLight(LightSource &source, LightLayers layer) const;
+	/// Replaces the dynamic light sources that changed and relights the tiles they reach.
+	void updateDynamicLights(LightLayers layer, MapSubset scope, std::map<std::pair<int, int>, LightSource> &found, MapSubset affected);
+	/// Traces the explosion rays leaving at one vertical angle.
+	void traceExplosionRays(const Explosion &explosion, int fi, std::vector<std::pair<Tile*, int> > &steps);
 	/// Calculate blockage amount.
 	int blockage(Tile *tile, const TilePart part, ItemDamageType type, int direction = -1, bool checkingFromOrigin = false);
 
-	bool setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius);
-	inline bool inEventVisibilitySector(const Position &toCheck) const;
+	/// Narrow circle sector covering an event, as seen from an observer.
+	struct EventVisibilitySector
+	{
+		Position left, right, observerPos;
+	};
+	/// Visibility changes of one unit, found in parallel and applied later in unit order.
+	struct FOVUpdate
+	{
+		/// Drop the visible tiles before adding the new ones.
+		bool clearTiles = false;
+		/// Tiles in sight, in the order they were reached.
+		std::vector<Tile*> tiles;
+		/// Drop the visible units before applying the changes.
+		bool clearUnits = false;
+		/// Units checked, and whether they are seen.
+		std::vector<std::pair<BattleUnit*, bool> > units;
+	};
+
+	bool setupEventVisibilitySector(EventVisibilitySector &sector, const Position &observerPos, const Position &eventPos, const int &eventRadius) const;
+	inline bool inEventVisibilitySector(const EventVisibilitySector &sector, const Position &toCheck) const;
+	/// Finds the tiles in sight of a unit, without changing anything.
+	void findTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, FOVUpdate &update);
+	/// Finds the units in sight of a unit, without changing anything.
+	void findUnitsInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, FOVUpdate &update);
+	/// Applies the tiles found by findTilesInFOV.
+	void applyTilesInFOV(BattleUnit *unit, const FOVUpdate &update);
+	/// Applies the units found by findUnitsInFOV.
+	bool applyUnitsInFOV(BattleUnit *unit, const FOVUpdate &update);
+	/// Updates the line of sight of several units, using the worker threads.
+	void calculateFOVOfUnits(const std::vector<BattleUnit*> &units, Position eventPos, int eventRadius, bool updateTiles, bool appendToTileVisibility);
 
 	/// Calculates sun shading of the whole map.
 	void calculateSunShading(MapSubset gs);
 	/// Recalculates lighting of the battlescape for terrain.
 	void calculateTerrainBackground(MapSubset gs);
-	/// Recalculates lighting of the battlescape for terrain.
-	void calculateTerrainItems(MapSubset gs);
+	/// Recalculates lighting of the battlescape for items.
+	void calculateTerrainItems(MapSubset gs, MapSubset affected);
 	/// Recalculates lighting of the battlescape for units.
-	void calculateUnitLighting(MapSubset gs);
+	void calculateUnitLighting(MapSubset affected);
 
 	/// Checks validity of a snap shot to this position.
 	ReactionScore determineReactionType(BattleUnit *unit, BattleUnit *target);
@@ -185,6 +256,8 @@ public:
 	void calculateFOV(Position position, int eventRadius = -1, const bool updateTiles = true, const bool appendToTileVisibility = false);
 	/// Checks reaction fire.
 	bool checkReactionFire(BattleUnit *unit, const BattleAction &originalAction);
+	/// Counts potential reaction fire shooters without firing.
+	int countReactionFireSpotters(BattleUnit *unit);
 	/// Recalculate all lighting in some area.
 	void calculateLighting(LightLayers layer, Position position = invalid, int eventRadius = 0, bool terrianChanged = false);
 	/// Handles tile hit.
@@ -197,6 +270,8 @@ public:
 	void hit(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, bool rangeAtack = true, int terrainMeleeTilePart = 0);
 	/// Handles explosions.
 	void explode(BattleActionAttack attack, Position center, int power, const RuleDamageType *type, int maxRadius, bool rangeAtack = true);
+	/// Handles several explosions at once.
+	void explodeBatch(const std::vector<Explosion> &explosions);
 	/// Checks if a destroyed tile starts an explosion.
 	Tile *checkForTerrainExplosions();
 	/// Unit opens door?
@@ -277,6 +352,10 @@ public:
 	VoxelType voxelCheck(Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits = false, bool onlyVisible = false, BattleUnit *excludeAllBut = 0);
 	/// Flushes cache of voxel check
 	void voxelCheckFlush();
+	/// Updates the terrain voxels of changed tiles.
+	void updateVoxelGrid(Position pos, int radius = 0);
+	/// Forgets which units could see which tiles.
+	void invalidateVisibility() { _visibilityCache.invalidate(); }
 	/// Blows this tile up.
 	bool detonate(Tile* tile, int power);
 	/// Validates a throwing action.
@@ -137,7 +137,10 @@ void UnitFallBState::think()
 				// if the unit burns floor tiles, burn floor tiles
 				if (unit->getSpecialAbility() == SPECAB_BURNFLOOR || unit->getSpecialAbility() == SPECAB_BURN_AND_EXPLODE)
 				{
-					unit->getTile()->ignite(1);
+					if (unit->getTile()->ignite(1))
+					{
+						_parent->getPathfinding()->invalidateReachable();
+					}
 					Position groundVoxel = (unit->getPosition().toVoxel()) + Position(8,8,-(unit->getTile()->getTerrainLevel()));
 					_parent->getTileEngine()->hit(BattleActionAttack{ BA_NONE, unit, }, groundVoxel, unit->getBaseStats()->strength, _parent->getMod()->getDamageType(DT_IN), false);
 
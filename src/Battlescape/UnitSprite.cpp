@@ -27,18 +27,231 @@
 #include "../Mod/RuleInventory.h"
 #include "../Mod/Mod.h"
 #include "../Engine/Exception.h"
+#include "../Engine/ShaderDraw.h"
+#include "../Engine/ShaderMove.h"
+#include <algorithm>
+#include <limits>
 
 namespace OpenXcom
 {
 
+/**
+ * Creates an empty cache.
+ * @param budget Memory in bytes that sprites can use.
+ */
+UnitSpriteCache::UnitSpriteCache(size_t budget) : _size(0), _budget(budget)
+{
+
+}
+
+/**
+ * Deletes the cached sprites.
+ */
+UnitSpriteCache::~UnitSpriteCache()
+{
+
+}
+
+/**
+ * Hashes the inputs of a recolor script.
+ * @param recolor Inputs of the script.
+ * @return Hash.
+ */
+size_t UnitSpriteCache::RecolorHash::operator()(const Recolor &recolor) const
+{
+	size_t key = std::hash<const void*>()(recolor.rules);
+	key = key * 31 + std::hash<const void*>()(recolor.owner);
+	key = key * 31 + std::hash<const void*>()(recolor.src);
+	key = key * 31 + (size_t)recolor.part;
+	key = key * 31 + (size_t)recolor.animFrame;
+	key = key * 31 + (size_t)recolor.shade;
+	key = key * 31 + (size_t)recolor.burn;
+	return key;
+}
+
+/**
+ * Gets the sprite composed from the given frames, composing it if it is not in the cache.
+ * On a hit only the inputs of the recolor scripts are looked up, no script is run.
+ * @param layers Frames to compose, in drawing order.
+ * @param works Script worker for each frame, used when its colors are not known yet.
+ * @return Composed sprite.
+ */
+std::shared_ptr<const UnitSpriteCache::Sprite> UnitSpriteCache::get(const std::vector<Layer> &layers, std::vector<ScriptWorkerBlit> &works)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_found.clear();
+	size_t key = layers.size();
+	for (size_t l = 0; l < layers.size(); ++l)
+	{
+		const auto& layer = layers[l];
+		const Colors &colors = getRecolor(layer, works[l]);
+		_found.push_back(&colors);
+		key = key * 31 + std::hash<const void*>()(layer.recolor.src);
+		key = key * 31 + (size_t)(layer.offX * 256 + layer.offY);
+		key = key * 31 + colors.hash;
+	}
+
+	auto same = [&](const Entry &entry)
+	{
+		if (entry.layers.size() != layers.size())
+		{
+			return false;
+		}
+		for (size_t l = 0; l < layers.size(); ++l)
+		{
+			const auto& cached = entry.layers[l];
+			if (cached.src != layers[l].recolor.src || cached.offX != layers[l].offX || cached.offY != layers[l].offY || cached.table != _found[l]->table)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+	auto i = _index.find(key);
+	if (i != _index.end())
+	{
+		if (same(*i->second))
+		{
+			_entries.splice(_entries.begin(), _entries, i->second);
+			return i->second->sprite;
+		}
+		_size -= i->second->sprite->pixels.size();
+		_entries.erase(i->second);
+		_index.erase(i);
+	}
+
+	auto sprite = std::make_shared<Sprite>();
+	int endX = std::numeric_limits<int>::min(), endY = std::numeric_limits<int>::min();
+	sprite->x = std::numeric_limits<int>::max();
+	sprite->y = std::numeric_limits<int>::max();
+	for (const auto& layer : layers)
+	{
+		sprite->x = std::min(sprite->x, layer.offX);
+		sprite->y = std::min(sprite->y, layer.offY);
+		endX = std::max(endX, layer.offX + layer.recolor.src->getWidth());
+		endY = std::max(endY, layer.offY + layer.recolor.src->getHeight());
+	}
+	sprite->width = endX - sprite->x;
+	sprite->height = endY - sprite->y;
+	sprite->pixels.assign(sprite->width * sprite->height, 0);
+	SurfaceRaw<Uint8> dest(sprite->pixels.data(), sprite->width, sprite->height, sprite->width);
+	Entry entry{ key, { }, sprite };
+	for (size_t l = 0; l < layers.size(); ++l)
+	{
+		const auto& layer = layers[l];
+		const auto& table = _found[l]->table;
+		ShaderDrawFunc(
+			[&](Uint8& destStuff, const Uint8& srcStuff)
+			{
+				if (srcStuff && table[srcStuff]) destStuff = table[srcStuff];
+			},
+			ShaderMove<Uint8>(dest),
+			ShaderMove<const Uint8>(SurfaceRaw<const Uint8>(layer.recolor.src), layer.offX - sprite->x, layer.offY - sprite->y)
+		);
+		entry.layers.push_back(EntryLayer{ layer.recolor.src, layer.offX, layer.offY, table });
+	}
+
+	_entries.push_front(std::move(entry));
+	_index[key] = _entries.begin();
+	_size += sprite->pixels.size();
+	while (_size > _budget && _entries.size() > 1)
+	{
+		_size -= _entries.back().sprite->pixels.size();
+		_index.erase(_entries.back().key);
+		_entries.pop_back();
+	}
+	return sprite;
+}
+
+/**
+ * Forgets the colors given by recolor scripts.
+ * Scripts can read unit state that is not one of their inputs,
+ * so this is called every animation frame, before the map is drawn.
+ */
+void UnitSpriteCache::clearRecolors()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_recolors.clear();
+}
+
+/**
+ * Gets the colors the recolor script of a frame gives to it, running the script only for new inputs.
+ * Called with the mutex locked.
+ * @param layer Frame and inputs of its script.
+ * @param work Script worker set up with these inputs.
+ * @return Final color of every color of the frame.
+ */
+const UnitSpriteCache::Colors &UnitSpriteCache::getRecolor(const Layer &layer, ScriptWorkerBlit &work)
+{
+	auto ret = _recolors.emplace(layer.recolor, Colors{ });
+	Colors &colors = ret.first->second;
+	if (ret.second)
+	{
+		size_t hash = 0;
+		for (Uint8 color : getColors(layer.recolor.src))
+		{
+			if (work.hasScript())
+			{
+				colors.table[color] = work.executePixel(color, 0);
+			}
+			else
+			{
+				helper::StandardShade::func(colors.table[color], color, layer.recolor.shade);
+			}
+			hash = hash * 31 + colors.table[color];
+		}
+		colors.hash = hash;
+	}
+	return colors;
+}
+
+/**
+ * Gets the list of colors used by a frame, computed once for each frame.
+ * Called with the mutex locked, the returned list is valid until the next call.
+ * @param src Frame.
+ * @return Colors other than transparent present in the frame, in increasing order.
+ */
+const std::vector<Uint8> &UnitSpriteCache::getColors(const Surface *src)
+{
+	auto i = _colors.find(src);
+	if (i != _colors.end())
+	{
+		return i->second;
+	}
+	if (_colors.size() >= MaxColorFrames)
+	{
+		_colors.clear();
+	}
+	auto& colors = _colors[src];
+	bool used[256] = { };
+	for (int y = 0; y < src->getHeight(); ++y)
+	{
+		const Uint8 *row = src->getBuffer() + y * src->getPitch();
+		for (int x = 0; x < src->getWidth(); ++x)
+		{
+			used[row[x]] = true;
+		}
+	}
+	for (int color = 1; color < 256; ++color)
+	{
+		if (used[color])
+		{
+			colors.push_back(color);
+		}
+	}
+	return colors;
+}
+
 /**
  * Sets up a UnitSprite with the specified size and position.
  * @param width Width in pixels.
  * @param height Height in pixels.
  * @param x X position in pixels.
  * @param y Y position in pixels.
+ * @param cache Cache of composed sprites, can be null.
  */
-UnitSprite::UnitSprite(Surface* dest, const Mod* mod, const SavedBattleGame* save, int frame, bool helmet, int red, int blue) :
+UnitSprite::UnitSprite(Surface* dest, const Mod* mod, const SavedBattleGame* save, int frame, bool helmet, int red, int blue, UnitSpriteCache* cache) :
 	_unit(0), _itemR(0), _itemL(0),
 	_unitSurface(0),
 	_itemSurface(const_cast<Mod*>(mod)->getSurfaceSet("HANDOB.PCK")),
@@ -50,7 +263,7 @@ UnitSprite::UnitSprite(Surface* dest, const Mod* mod, const SavedBattleGame* sav
 	_helmet(helmet),
 	_red(red), _blue(blue),
 	_x(0), _y(0), _shade(0), _burn(0),
-	_mask(0, 0)
+	_mask(0, 0), _cache(cache)
 {
 
 }
@@ -144,14 +357,11 @@ void UnitSprite::blitItem(Part& item)
 	{
 		return;
 	}
+	const BattleItem *owner = (item.bodyPart == BODYPART_ITEM_RIGHTHAND ? _itemR : _itemL);
 	ScriptWorkerBlit work;
-	BattleItem::ScriptFill(&work, (item.bodyPart == BODYPART_ITEM_RIGHTHAND ? _itemR : _itemL), _save, item.bodyPart, _animationFrame, _shade);
-
-	_dest->lock();
+	BattleItem::ScriptFill(&work, owner, _save, item.bodyPart, _animationFrame, _shade);
 
-	work.executeBlit(item.src, _dest,  _x + item.offX, _y + item.offY, _shade, _mask);
-
-	_dest->unlock();
+	blitPart(item, work, owner ? owner->getRules() : nullptr, owner, 0);
 }
 
 /**
@@ -167,11 +377,59 @@ void UnitSprite::blitBody(Part& body)
 	ScriptWorkerBlit work;
 	BattleUnit::ScriptFill(&work, _unit, _save, body.bodyPart, _animationFrame, _shade, _burn);
 
+	blitPart(body, work, _unit ? _unit->getArmor() : nullptr, _unit, _burn);
+}
+
+/**
+ * Blit sprite of unit or item.
+ * Parts are only collected, with the inputs of their recolor script, to be drawn together from the cache.
+ * Recolor scripts that read the destination pixel can't be cached, parts with them are always blitted directly.
+ * @param part sprite part.
+ * @param work script worker for the part.
+ * @param rules rules owning the recolor script (armor or item).
+ * @param owner unit or item the script is run for.
+ * @param burn burn value given to the script.
+ */
+void UnitSprite::blitPart(Part& part, ScriptWorkerBlit& work, const void *rules, const void *owner, int burn)
+{
+	if (_cache && !work.isDestUsed())
+	{
+		_layers.push_back(UnitSpriteCache::Layer{ { rules, owner, part.src, part.bodyPart, _animationFrame, _shade, burn }, part.offX, part.offY });
+		_works.push_back(work);
+		return;
+	}
+
+	blitLayers();
+
+	_dest->lock();
+
+	work.executeBlit(part.src, _dest,  _x + part.offX, _y + part.offY, _shade, _mask);
+
+	_dest->unlock();
+}
+
+/**
+ * Blit parts collected by blitPart, using the composed sprite from the cache.
+ */
+void UnitSprite::blitLayers()
+{
+	if (_layers.empty())
+	{
+		return;
+	}
+
 	_dest->lock();
 
-	work.executeBlit(body.src, _dest,  _x + body.offX, _y + body.offY, _shade, _mask);
+	auto sprite = _cache->get(_layers, _works);
+	ShaderMove<const Uint8> src(SurfaceRaw<const Uint8>(sprite->pixels.data(), sprite->width, sprite->height, sprite->width), _x + sprite->x, _y + sprite->y);
+	ShaderMove<Uint8> dest(_dest);
+	dest.setDomain(_mask);
+	ShaderDraw<helper::StandardShade>(dest, src, ShaderScalar(0));
 
 	_dest->unlock();
+
+	_layers.clear();
+	_works.clear();
 }
 
 /**
@@ -247,6 +505,7 @@ void UnitSprite::draw(const BattleUnit* unit, int part, int x, int y, int shade,
 	};
 	// Call the matching routine
 	(this->*(routines[_drawingRoutine]))();
+	blitLayers();
 	// draw fire
 	if (unit->getFire() > 0)
 	{
@@ -19,6 +19,12 @@
  */
 #include "../Engine/Surface.h"
 #include "../Engine/Script.h"
+#include <vector>
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace OpenXcom
 {
@@ -29,6 +35,91 @@ class SavedBattleGame;
 class SurfaceSet;
 class Mod;
 
+/**
+ * Cache of unit sprites composed from several frames (torso, legs, arms, weapons...),
+ * so a unit that keeps the same pose is drawn with one blit instead of one per part.
+ * The colors a recolor script gives to a frame are kept for its inputs until the next animation frame,
+ * composed sprites are kept for the final colors of their frames and dropped least recently used
+ * first when over the memory budget.
+ * Shared by every UnitSprite drawing the same map, so it can be used from several threads.
+ */
+class UnitSpriteCache
+{
+public:
+	/// Inputs of the recolor script of one frame.
+	struct Recolor
+	{
+		const void *rules;
+		const void *owner;
+		const Surface *src;
+		int part, animFrame, shade, burn;
+
+		bool operator==(const Recolor &other) const { return rules == other.rules && owner == other.owner && src == other.src && part == other.part && animFrame == other.animFrame && shade == other.shade && burn == other.burn; }
+	};
+	/// One frame of the composed sprite.
+	struct Layer
+	{
+		Recolor recolor;
+		int offX;
+		int offY;
+	};
+	/// Composed sprite.
+	struct Sprite
+	{
+		std::vector<Uint8> pixels;
+		int x, y, width, height;
+	};
+
+	/// Creates a cache using up to given number of bytes.
+	UnitSpriteCache(size_t budget);
+	/// Cleans up the cache.
+	~UnitSpriteCache();
+	/// Gets the sprite composed from the given frames.
+	std::shared_ptr<const Sprite> get(const std::vector<Layer> &layers, std::vector<ScriptWorkerBlit> &works);
+	/// Forgets the colors given by recolor scripts.
+	void clearRecolors();
+
+private:
+	/// Final color of every color of a frame.
+	struct Colors
+	{
+		std::array<Uint8, 256> table;
+		size_t hash;
+	};
+	struct RecolorHash
+	{
+		size_t operator()(const Recolor &recolor) const;
+	};
+	struct EntryLayer
+	{
+		const Surface *src;
+		int offX;
+		int offY;
+		std::array<Uint8, 256> table;
+	};
+	struct Entry
+	{
+		size_t key;
+		std::vector<EntryLayer> layers;
+		std::shared_ptr<const Sprite> sprite;
+	};
+	/// Most frames that have their list of colors kept.
+	static constexpr size_t MaxColorFrames = 4096;
+
+	std::mutex _mutex;
+	std::list<Entry> _entries;
+	std::unordered_map<size_t, std::list<Entry>::iterator> _index;
+	std::unordered_map<Recolor, Colors, RecolorHash> _recolors;
+	std::unordered_map<const Surface*, std::vector<Uint8>> _colors;
+	std::vector<const Colors*> _found;
+	size_t _size, _budget;
+
+	/// Gets the colors a recolor script gives to a frame.
+	const Colors &getRecolor(const Layer &layer, ScriptWorkerBlit &work);
+	/// Gets the list of colors used by a frame.
+	const std::vector<Uint8> &getColors(const Surface *src);
+};
+
 /**
  * A class that renders a specific unit, given its render rules
  * combining the right frames from the surfaceset.
@@ -60,6 +151,9 @@ private:
 	int _red, _blue;
 	int _x, _y, _shade, _burn;
 	GraphSubset _mask;
+	UnitSpriteCache *_cache;
+	std::vector<UnitSpriteCache::Layer> _layers;
+	std::vector<ScriptWorkerBlit> _works;
 
 	/// Drawing routine for XCom soldiers in overalls, sectoids (routine 0),
 	/// mutons (routine 10),
@@ -107,9 +201,13 @@ private:
 	void blitItem(Part& item);
 	/// Blit body sprite.
 	void blitBody(Part& body);
+	/// Blit sprite of any part.
+	void blitPart(Part& part, ScriptWorkerBlit& work, const void *rules, const void *owner, int burn);
+	/// Blit parts waiting to be drawn from the cache.
+	void blitLayers();
 public:
 	/// Creates a new UnitSprite at the specified position and size.
-	UnitSprite(Surface* dest, const Mod* mod, const SavedBattleGame* save, int frame, bool helmet, int red, int blue);
+	UnitSprite(Surface* dest, const Mod* mod, const SavedBattleGame* save, int frame, bool helmet, int red, int blue, UnitSpriteCache* cache = nullptr);
 	/// Cleans up the UnitSprite.
 	~UnitSprite();
 	/// Draws the unit.
@@ -201,7 +201,10 @@ void UnitWalkBState::think()
 			// if the unit burns floor tiles, burn floor tiles as long as we're not falling
 			if (!_falling && (_unit->getSpecialAbility() == SPECAB_BURNFLOOR || _unit->getSpecialAbility() == SPECAB_BURN_AND_EXPLODE))
 			{
-				_unit->getTile()->ignite(1);
+				if (_unit->getTile()->ignite(1))
+				{
+					_pf->invalidateReachable();
+				}
 				Position posHere = _unit->getPosition();
 				Position voxelHere = posHere.toVoxel() + Position(8,8,-(_unit->getTile()->getTerrainLevel()));
 				_parent->getTileEngine()->hit(BattleActionAttack{ BA_NONE, _unit, }, voxelHere, _unit->getBaseStats()->strength, _parent->getMod()->getDamageType(DT_IN), false);
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "VisibilityCache.h"
+#include <cassert>
+
+namespace OpenXcom
+{
+
+/**
+ * Creates an empty cache, version 0 is never used so empty slots never match.
+ */
+VisibilityCache::VisibilityCache() : _entries(new std::atomic<uint64_t>[Slots]), _version(0)
+{
+	invalidate();
+}
+
+/**
+ * Deletes the cache.
+ */
+VisibilityCache::~VisibilityCache()
+{
+
+}
+
+/**
+ * Forgets every stored result by starting a new version.
+ * Must not be called while other threads look at the cache.
+ */
+void VisibilityCache::invalidate()
+{
+	++_version;
+	if (_version == 1 || _version >= (1u << VersionBits))
+	{
+		_version = 1;
+		for (int i = 0; i < Slots; ++i)
+		{
+			_entries[i].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+#ifndef NDEBUG
+static auto dummy = ([]
+{
+	VisibilityCache cache;
+	assert(cache.get(5, 100) == -1);
+	cache.set(5, 100, true);
+	cache.set(5 + (1 << 12), 100, false); // same slot, different observer
+	assert(cache.get(5, 100) == -1);
+	assert(cache.get(5 + (1 << 12), 100) == 0);
+	cache.set(1000001, 4000, true);
+	assert(cache.get(1000001, 4000) == 1);
+	cache.invalidate();
+	assert(cache.get(1000001, 4000) == -1);
+	assert(cache.get(-1, 4000) == -1);
+
+	return 0;
+})();
+#endif
+
+}
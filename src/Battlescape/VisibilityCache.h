@@ -0,0 +1,96 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Remembers which units could see which tiles since the battlefield last changed.
+ * The same pairs are checked again and again during a single action: by the field
+ * of view of the moving unit, by everyone who can see it and then by reaction fire.
+ * Any change to terrain, light, smoke or unit positions bumps the version,
+ * which forgets everything at once.
+ *
+ * Every entry is one 64 bit word, so lookups are safe from worker threads
+ * while the version stays the same. The low bits of the observer id are not
+ * stored but give the slot, so two different pairs can never be mistaken.
+ */
+class VisibilityCache
+{
+	static constexpr int SlotBits = 12;
+	static constexpr int Slots = 1 << SlotBits;
+	static constexpr int TileBits = 24;
+	static constexpr int IdBits = 19;
+	static constexpr int VersionBits = 64 - 1 - TileBits - IdBits;
+
+	std::unique_ptr<std::atomic<uint64_t>[]> _entries;
+	Uint32 _version;
+
+	/// Gets the slot of a pair.
+	static int getSlot(int observerId, int tileIndex)
+	{
+		return (observerId ^ (int)(((Uint32)tileIndex * 2654435761u) >> (32 - SlotBits))) & (Slots - 1);
+	}
+	/// Gets the entry of a pair, without the result.
+	uint64_t getKey(int observerId, int tileIndex) const
+	{
+		return ((uint64_t)_version << (1 + TileBits + IdBits)) | ((uint64_t)(observerId >> SlotBits) << (1 + TileBits)) | ((uint64_t)tileIndex << 1);
+	}
+	/// Can a pair be stored at all?
+	static bool isStorable(int observerId, int tileIndex)
+	{
+		return observerId >= 0 && (observerId >> (SlotBits + IdBits)) == 0 && tileIndex >= 0 && (tileIndex >> TileBits) == 0;
+	}
+public:
+	/// Creates an empty cache.
+	VisibilityCache();
+	/// Cleans up the cache.
+	~VisibilityCache();
+	/// Forgets every stored result.
+	void invalidate();
+	/// Gets a stored result: 1 seen, 0 not seen, -1 unknown.
+	int get(int observerId, int tileIndex) const
+	{
+		if (!isStorable(observerId, tileIndex))
+		{
+			return -1;
+		}
+		uint64_t entry = _entries[getSlot(observerId, tileIndex)].load(std::memory_order_relaxed);
+		if ((entry & ~(uint64_t)1) != getKey(observerId, tileIndex))
+		{
+			return -1;
+		}
+		return (int)(entry & 1);
+	}
+	/// Stores a result.
+	void set(int observerId, int tileIndex, bool seen)
+	{
+		if (isStorable(observerId, tileIndex))
+		{
+			_entries[getSlot(observerId, tileIndex)].store(getKey(observerId, tileIndex) | (seen ? 1 : 0), std::memory_order_relaxed);
+		}
+	}
+};
+
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "VoxelGrid.h"
+#include "../Mod/MapData.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates an empty grid, with only the empty shape.
+ */
+VoxelGrid::VoxelGrid() : _voxelData(0)
+{
+	getShape(ShapeKey{});
+}
+
+/**
+ * Deletes the grid.
+ */
+VoxelGrid::~VoxelGrid()
+{
+
+}
+
+/**
+ * Gets the shape made of some tile parts.
+ * New combinations get their rows merged from the LOFTEMPS of every part.
+ * @param key Parts of the tile and grav lift flag.
+ * @return Index of the shape.
+ */
+Uint32 VoxelGrid::getShape(const ShapeKey &key)
+{
+	auto it = _shapes.find(key);
+	if (it != _shapes.end())
+	{
+		return it->second;
+	}
+
+	Uint32 shape = _shapes.size();
+	_shapes[key] = shape;
+	_shapeRows.resize(_shapeRows.size() + ShapeRows, 0);
+	Uint16 *rows = &_shapeRows[shape * ShapeRows];
+	for (const auto *mapData : key.first)
+	{
+		if (!mapData)
+		{
+			continue;
+		}
+		for (int layer = 0; layer < 12; ++layer)
+		{
+			for (int y = 0; y < 16; ++y)
+			{
+				rows[layer * 16 + y] |= _voxelData->at(mapData->getLoftID(layer) * 16 + y);
+			}
+		}
+	}
+	if (key.second)
+	{
+		// the two lowest voxels of a grav lift on top of no other lift are all floor
+		for (int y = 0; y < 16; ++y)
+		{
+			rows[y] = 0xFFFF;
+		}
+	}
+	return shape;
+}
+
+/**
+ * Builds the voxels of every tile of a battle.
+ * @param save Pointer to the battle.
+ * @param voxelData LOFTEMPS of the mod.
+ */
+void VoxelGrid::init(SavedBattleGame *save, const std::vector<Uint16> *voxelData)
+{
+	_voxelData = voxelData;
+	_tileShape.assign(save->getMapSizeXYZ(), 0);
+	for (int i = 0; i < save->getMapSizeXYZ(); ++i)
+	{
+		update(save, save->getTile(i));
+	}
+}
+
+/**
+ * Rebuilds the voxels of a tile after its parts or doors changed.
+ * The grav lift floor depends on the tile below, so when a floor changes
+ * the tile above needs an update too.
+ * @param save Pointer to the battle.
+ * @param tile Changed tile.
+ */
+void VoxelGrid::update(SavedBattleGame *save, Tile *tile)
+{
+	ShapeKey key{};
+	for (int i = O_FLOOR; i <= O_OBJECT; ++i)
+	{
+		TilePart tp = (TilePart)i;
+		if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
+			continue;
+		key.first[i] = tile->getMapData(tp);
+	}
+	if (tile->hasGravLiftFloor())
+	{
+		Tile *tileBelow = save->getBelowTile(tile);
+		key.second = !(tileBelow && tileBelow->hasGravLiftFloor());
+	}
+	_tileShape[save->getTileIndex(tile->getPosition())] = getShape(key);
+}
+
+}
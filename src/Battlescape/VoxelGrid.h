@@ -0,0 +1,75 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include <map>
+#include <utility>
+#include <vector>
+#include <SDL_types.h>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class MapData;
+class Tile;
+
+/**
+ * Packed terrain voxels of the whole battlescape map, units not included.
+ * Every tile points to a shape: 12 layers of 16 rows of 16 bits, in the
+ * LOFTEMPS row format, with all the tile parts merged together.
+ * Tiles built from the same parts share their shape, so the grid stays small
+ * even on big maps, and a voxel test is two loads and a mask.
+ */
+class VoxelGrid
+{
+public:
+	/// Rows of one shape, LOFT layers of two voxels times 16 rows.
+	static constexpr int ShapeRows = 12 * 16;
+
+private:
+	/// What a shape is made of: the solid parts and whether the grav lift floor blocks.
+	typedef std::pair<std::array<const MapData*, 4>, bool> ShapeKey;
+
+	const std::vector<Uint16> *_voxelData;
+	std::vector<Uint32> _tileShape;
+	std::vector<Uint16> _shapeRows;
+	std::map<ShapeKey, Uint32> _shapes;
+
+	/// Gets the shape for a combination of parts, creating it if needed.
+	Uint32 getShape(const ShapeKey &key);
+public:
+	/// Creates an empty grid.
+	VoxelGrid();
+	/// Cleans up the grid.
+	~VoxelGrid();
+	/// Builds the grid for all the tiles of the battle.
+	void init(SavedBattleGame *save, const std::vector<Uint16> *voxelData);
+	/// Rebuilds the voxels of one tile.
+	void update(SavedBattleGame *save, Tile *tile);
+	/// Does a voxel of a tile contain terrain?
+	bool isTerrain(int tileIndex, Position voxel) const
+	{
+		Uint16 row = _shapeRows[_tileShape[tileIndex] * ShapeRows + ((voxel.z % 24) / 2) * 16 + voxel.y % 16];
+		return row & (1 << (15 - voxel.x % 16));
+	}
+};
+
+}
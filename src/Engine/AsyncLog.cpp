@@ -0,0 +1,285 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AsyncLog.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <SDL.h>
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Number of messages the ring can hold, must be a power of two.
+const size_t RingSize = 1 << 12;
+/// How long the writer sleeps between batches.
+const std::chrono::milliseconds WriteInterval(50);
+
+/**
+ * A slot of the ring. The sequence tells whose turn it is:
+ * equal to the position when free for a producer,
+ * one past it when holding a message for the writer.
+ */
+struct Record
+{
+	std::atomic<size_t> sequence;
+	std::string msg;
+	bool echo;
+};
+
+Record ring[RingSize];
+std::atomic<size_t> enqueuePos(0);
+std::atomic<bool> running(false);
+/// Producers between checking running and publishing their message.
+std::atomic<int> pushing(0);
+/// Position of the next message to write, producers read it to see how full the ring is.
+std::atomic<size_t> dequeuePos(0);
+
+/// Only one thread writes at a time, it protects everything below
+/// and changes to dequeuePos.
+std::mutex writeMutex;
+std::string logFile;
+
+/// Wakes the writer thread early.
+std::mutex wakeMutex;
+std::condition_variable wake;
+bool quit = false;
+std::thread writer;
+
+/**
+ * Appends a batch of messages to the log file, logs nothing to avoid recursion.
+ * @param batch Messages for the log file.
+ * @param echo Messages for stderr too.
+ */
+void writeBatch(const std::string &batch, const std::string &echo)
+{
+	if (!echo.empty())
+	{
+		fwrite(echo.c_str(), echo.size(), 1, stderr);
+		fflush(stderr);
+	}
+	if (batch.empty())
+	{
+		return;
+	}
+	// Even SDL1 file IO accepts UTF-8 file names on windows.
+	SDL_RWops *rwops = SDL_RWFromFile(logFile.c_str(), "a+");
+	if (!rwops || SDL_RWwrite(rwops, batch.c_str(), batch.size(), 1) != 1)
+	{
+		fprintf(stderr, "Failed to append to '%s': %s\n", logFile.c_str(), SDL_GetError());
+	}
+	if (rwops)
+	{
+		SDL_RWclose(rwops);
+	}
+}
+
+/**
+ * Takes all queued messages out of the ring and writes them.
+ * The write mutex must be held.
+ */
+void drain()
+{
+	std::string batch, echo;
+	size_t pos = dequeuePos.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		Record &record = ring[pos & (RingSize - 1)];
+		if (record.sequence.load(std::memory_order_acquire) != pos + 1)
+		{
+			break;
+		}
+		batch += record.msg;
+		if (record.echo)
+		{
+			echo += record.msg;
+		}
+		record.msg.clear();
+		record.sequence.store(pos + RingSize, std::memory_order_release);
+		++pos;
+	}
+	dequeuePos.store(pos, std::memory_order_relaxed);
+	writeBatch(batch, echo);
+}
+
+/**
+ * Writes the queue out every so often, or sooner when it fills up.
+ */
+void writerLoop()
+{
+	for (;;)
+	{
+		{
+			std::lock_guard<std::mutex> lock(writeMutex);
+			drain();
+		}
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		if (quit)
+		{
+			break;
+		}
+		wake.wait_for(lock, WriteInterval);
+	}
+}
+
+}
+
+/**
+ * Starts queueing messages and the thread that writes them.
+ * The queue is also written out when the program exits.
+ * @param filename Path of the log file.
+ */
+void AsyncLog::start(const std::string &filename)
+{
+	static bool registered = false;
+	std::lock_guard<std::mutex> lock(writeMutex);
+	if (running)
+	{
+		return;
+	}
+	logFile = filename;
+	size_t pos = dequeuePos.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < RingSize; ++i)
+	{
+		ring[i].sequence.store(pos + i, std::memory_order_relaxed);
+	}
+	enqueuePos.store(pos, std::memory_order_relaxed);
+	quit = false;
+	writer = std::thread(writerLoop);
+	running = true;
+	if (!registered)
+	{
+		registered = true;
+		atexit(AsyncLog::stop);
+	}
+}
+
+/**
+ * Stops queueing messages, waits for the writer thread to finish
+ * and writes out the ones left, including any a producer was still
+ * publishing when the queue closed.
+ */
+void AsyncLog::stop()
+{
+	if (!writer.joinable())
+	{
+		return;
+	}
+	running = false;
+	// from here on push() refuses, wait out the ones already past the check
+	while (pushing.load() != 0)
+	{
+		std::this_thread::yield();
+	}
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		quit = true;
+	}
+	wake.notify_one();
+	writer.join();
+	std::lock_guard<std::mutex> lock(writeMutex);
+	drain();
+}
+
+/**
+ * Checks if messages should be queued instead of written.
+ * @return True if the writer thread is running.
+ */
+bool AsyncLog::isRunning()
+{
+	return running.load(std::memory_order_acquire);
+}
+
+/**
+ * Queues a message without blocking. Safe to call from any thread.
+ * @param msg Formatted message, including the line break.
+ * @param echo Also print it to stderr.
+ * @return False if the ring is full or stopped, the message wasn't queued.
+ */
+bool AsyncLog::push(const std::string &msg, bool echo)
+{
+	// sequentially consistent, pairs with stop() clearing running before it checks pushing
+	pushing.fetch_add(1);
+	if (!running.load())
+	{
+		pushing.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+	size_t pos = enqueuePos.load(std::memory_order_relaxed);
+	Record *record;
+	for (;;)
+	{
+		record = &ring[pos & (RingSize - 1)];
+		auto diff = static_cast<std::ptrdiff_t>(record->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0)
+		{
+			if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			pushing.fetch_sub(1, std::memory_order_release);
+			return false;
+		}
+		else
+		{
+			pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+	record->msg = msg;
+	record->echo = echo;
+	record->sequence.store(pos + 1, std::memory_order_release);
+	pushing.fetch_sub(1, std::memory_order_release);
+	// wake the writer early when the ring is half full
+	if (pos + 1 - dequeuePos.load(std::memory_order_relaxed) >= RingSize / 2)
+	{
+		wake.notify_one();
+	}
+	return true;
+}
+
+/**
+ * Writes out the queued messages right away, for fatal errors and
+ * when the ring is full. Gives up if the writer thread is stuck,
+ * in case it's the one that crashed.
+ */
+void AsyncLog::flush()
+{
+	for (int tries = 0; tries < 1000; ++tries)
+	{
+		std::unique_lock<std::mutex> lock(writeMutex, std::try_to_lock);
+		if (lock.owns_lock())
+		{
+			drain();
+			return;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+
+namespace OpenXcom
+{
+
+/**
+ * Writes log messages to the log file on a background thread.
+ * Any thread can queue an already formatted message without
+ * taking a lock: messages go into a fixed size ring buffer
+ * and the writer thread appends them to the file in batches.
+ * When the ring is full, or the message is fatal, the caller
+ * writes the queue out itself, so nothing is lost on a crash.
+ */
+class AsyncLog
+{
+public:
+	/// Starts the writer thread for a log file.
+	static void start(const std::string &filename);
+	/// Writes out the queued messages and stops the writer thread.
+	static void stop();
+	/// Checks if messages are being queued.
+	static bool isRunning();
+	/// Queues a message for the log file.
+	static bool push(const std::string &msg, bool echo);
+	/// Writes out the queued messages on the calling thread.
+	static void flush();
+};
+
+}
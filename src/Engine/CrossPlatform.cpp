@@ -32,6 +32,7 @@
 #include <sys/stat.h>
 #include <assert.h>
 #include "Logger.h"
+#include "AsyncLog.h"
 #include "Exception.h"
 #include "Options.h"
 #include "Unicode.h"
@@ -46,6 +47,7 @@
 #include <shellapi.h>
 #include <wininet.h>
 #include <urlmon.h>
+#include <psapi.h>
 #ifndef __NO_DBGHELP
 #include <dbghelp.h>
 #endif
@@ -59,6 +61,7 @@
 #pragma comment(lib, "shlwapi.lib")
 #pragma comment(lib, "wininet.lib")
 #pragma comment(lib, "urlmon.lib")
+#pragma comment(lib, "psapi.lib")
 #ifndef __NO_DBGHELP
 #pragma comment(lib, "dbghelp.lib")
 #endif
@@ -74,6 +77,7 @@
 #include <unistd.h>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <pwd.h>
 #ifndef __CYGWIN__
 #include <execinfo.h>
@@ -1623,6 +1627,15 @@ void log(int level, const std::ostringstream& baremsgstream) {
 	auto msg = msgstream.str();
 
 	int effectiveLevel = Logger::reportingLevel();
+	if (AsyncLog::isRunning() && logBuffer.empty()) {
+		if (AsyncLog::push(msg, effectiveLevel >= LOG_DEBUG)) {
+			if (level == LOG_FATAL) { // we might not be around for the writer
+				AsyncLog::flush();
+			}
+			return;
+		}
+		AsyncLog::flush(); // ring is full, write it out to keep the order
+	}
 	if (effectiveLevel >= LOG_DEBUG) {
 		fwrite(msg.c_str(), msg.size(), 1, stderr);
 		fflush(stderr);
@@ -1917,6 +1930,33 @@ void startUpdateProcess()
 #endif
 }
 
+/**
+ * Gets the peak resident memory of the process so far.
+ * @return Peak working set / max RSS in bytes, or 0 if not available.
+ */
+size_t getPeakMemoryUsage()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+#ifdef __APPLE__
+	return usage.ru_maxrss; // already in bytes
+#else
+	return usage.ru_maxrss * (size_t)1024; // in kilobytes
+#endif
+#endif
+}
+
 
 
 #ifndef NDEBUG
@@ -288,6 +288,8 @@ namespace CrossPlatform
 	std::string getExeFilename(bool includingPath);
 	/// Starts the update process.
 	void startUpdateProcess();
+	/// Gets the peak resident memory of the process.
+	size_t getPeakMemoryUsage();
 }
 
 }
@@ -285,11 +285,16 @@ RawData FileRecord::getUnzippedData() const
 	return RawData(data, size, mz_free);
 }
 
+RawData FileRecord::getRawData() const
+{
+	return zip != NULL ? getUnzippedData() : CrossPlatform::readFileRaw(fullpath);
+}
+
 YAML::YamlRootNodeReader FileRecord::getYAML() const
 {
 	try
 	{
-		RawData data = zip != NULL ? getUnzippedData() : CrossPlatform::readFileRaw(fullpath);
+		RawData data = getRawData();
 		return YAML::YamlRootNodeReader(data, fullpath);
 	}
 	catch(...)
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FrameProfiler.h"
+#include <algorithm>
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Phase times of the recent frames, in microseconds.
+int history[PHASE_COUNT][FrameProfiler::HISTORY] = {};
+/// Phase times of the frame being run.
+int current[PHASE_COUNT] = {};
+/// Slot of the newest closed frame.
+int newest = 0;
+/// Number of closed frames, up to HISTORY.
+int frames = 0;
+
+}
+
+bool FrameProfiler::_enabled = false;
+
+/**
+ * Turns timing on or off. Turning it on starts with an empty history.
+ * @param enabled Should the phases be timed?
+ */
+void FrameProfiler::setEnabled(bool enabled)
+{
+	if (enabled && !_enabled)
+	{
+		std::fill(&current[0], &current[0] + PHASE_COUNT, 0);
+		frames = 0;
+	}
+	_enabled = enabled;
+}
+
+/**
+ * Adds time spent in a phase. A phase can be entered
+ * many times a frame, eg. one logic tick after another.
+ * @param phase Frame phase.
+ * @param us Time in microseconds.
+ */
+void FrameProfiler::add(FramePhase phase, int us)
+{
+	current[phase] += us;
+}
+
+/**
+ * Moves the times of the current frame into the history
+ * and starts a new one.
+ */
+void FrameProfiler::endFrame()
+{
+	if (!_enabled)
+	{
+		return;
+	}
+	newest = (newest + 1) % HISTORY;
+	for (int i = 0; i < PHASE_COUNT; ++i)
+	{
+		history[i][newest] = current[i];
+		current[i] = 0;
+	}
+	frames = std::min(frames + 1, (int)HISTORY);
+}
+
+/**
+ * Returns the time spent in a phase during a recent frame.
+ * @param phase Frame phase.
+ * @param age 0 for the last frame, 1 for the one before and so on.
+ * @return Time in microseconds, 0 if the frame isn't known.
+ */
+int FrameProfiler::getTime(FramePhase phase, int age)
+{
+	if (age < 0 || age >= frames)
+	{
+		return 0;
+	}
+	return history[phase][(newest - age + HISTORY) % HISTORY];
+}
+
+/**
+ * Returns the statistics of a phase over the recent frames.
+ * @param phase Frame phase.
+ * @param min Gets the shortest time.
+ * @param avg Gets the average time.
+ * @param p99 Gets the time 99% of the frames stayed within.
+ */
+void FrameProfiler::getStats(FramePhase phase, int &min, int &avg, int &p99)
+{
+	min = avg = p99 = 0;
+	if (frames == 0)
+	{
+		return;
+	}
+	int sorted[HISTORY];
+	long long sum = 0;
+	for (int i = 0; i < frames; ++i)
+	{
+		sorted[i] = getTime(phase, i);
+		sum += sorted[i];
+	}
+	std::sort(sorted, sorted + frames);
+	min = sorted[0];
+	avg = (int)(sum / frames);
+	p99 = sorted[std::min(frames - 1, frames * 99 / 100)];
+}
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+
+namespace OpenXcom
+{
+
+/**
+ * Parts of a frame timed by the profiler. Phases nest, eg. Timers
+ * run inside Think and Scaling inside Flip.
+ */
+enum FramePhase
+{
+	PHASE_EVENTS,
+	PHASE_THINK,
+	PHASE_TIMERS,
+	PHASE_BLIT,
+	PHASE_FLIP,
+	PHASE_SCALING,
+	PHASE_SDL_FLIP,
+	PHASE_BATTLE_GAME,
+	PHASE_BATTLE_MAP,
+	PHASE_GEO_TIME,
+	PHASE_GEO_GLOBE,
+	PHASE_COUNT
+};
+
+/**
+ * Collects how long each phase of the recent frames took.
+ * Meant for the main thread only. When profiling is off, the only
+ * cost left is checking a flag on entering each phase.
+ */
+class FrameProfiler
+{
+public:
+	/// Number of frames kept.
+	static const int HISTORY = 128;
+private:
+	static bool _enabled;
+public:
+	/// Checks if the phases are being timed.
+	static bool isEnabled() { return _enabled; }
+	/// Turns timing on or off.
+	static void setEnabled(bool enabled);
+	/// Adds time spent in a phase during the current frame.
+	static void add(FramePhase phase, int us);
+	/// Closes the current frame.
+	static void endFrame();
+	/// Gets the time spent in a phase some frames ago.
+	static int getTime(FramePhase phase, int age);
+	/// Gets the statistics of a phase over the recent frames.
+	static void getStats(FramePhase phase, int &min, int &avg, int &p99);
+};
+
+/**
+ * Adds the time from its creation to its destruction to a frame phase.
+ */
+class ProfileScope
+{
+	FramePhase _phase;
+	bool _enabled;
+	std::chrono::steady_clock::time_point _start;
+public:
+	/// Starts timing a phase, if profiling.
+	ProfileScope(FramePhase phase) : _phase(phase), _enabled(FrameProfiler::isEnabled())
+	{
+		if (_enabled)
+		{
+			_start = std::chrono::steady_clock::now();
+		}
+	}
+	/// Stops timing the phase.
+	~ProfileScope()
+	{
+		stop();
+	}
+	/// Stops timing the phase before the end of the scope.
+	void stop()
+	{
+		if (_enabled)
+		{
+			FrameProfiler::add(_phase, (int)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count());
+			_enabled = false;
+		}
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope &operator=(const ProfileScope&) = delete;
+};
+
+}
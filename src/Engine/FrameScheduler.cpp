@@ -0,0 +1,188 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <thread>
+#include <SDL.h>
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Sleeps never end earlier than asked, but this much later is plausible.
+const std::chrono::milliseconds MaxSlack(4);
+/// Logic further behind than this is dropped, the game slows down instead of never catching up.
+const std::chrono::milliseconds MaxLag(250);
+
+}
+
+/**
+ * Creates a frame scheduler with unlimited frame rate.
+ * @param tickRate Logic ticks per second.
+ */
+FrameScheduler::FrameScheduler(int tickRate) : _tick(std::chrono::microseconds(1000000 / std::max(tickRate, 1))), _frame(Clock::duration::zero()), _slack(Clock::duration::zero()), _lag(Clock::duration::zero()), _frameIndex(0)
+{
+	_lastTick = _nextFrame = _lastFrame = Clock::now();
+	_frameTimes.reserve(FRAME_HISTORY);
+}
+
+/**
+ * Changes the frame rate. Frames are scheduled on a fixed cadence
+ * from the last one drawn.
+ * @param fps Frames per second, 0 for as fast as possible.
+ */
+void FrameScheduler::setFrameRate(int fps)
+{
+	Clock::duration frame = Clock::duration::zero();
+	if (fps > 0)
+	{
+		frame = std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(1000000 / fps));
+	}
+	if (frame != _frame)
+	{
+		_frame = frame;
+		_nextFrame = _lastFrame + _frame;
+	}
+}
+
+/**
+ * Adds the real time passed since the last check to the logic lag,
+ * and takes one tick off it if a whole one has built up. Call this
+ * until it returns false to run every tick that is due back to back.
+ * The lag is capped, so after a stall (or while the game is paused)
+ * the logic doesn't race to catch up.
+ * @return True if the logic should run one tick.
+ */
+bool FrameScheduler::tickDue()
+{
+	Clock::time_point now = Clock::now();
+	_lag = std::min<Clock::duration>(_lag + (now - _lastTick), MaxLag);
+	_lastTick = now;
+	if (_lag < _tick)
+	{
+		return false;
+	}
+	_lag -= _tick;
+	return true;
+}
+
+/**
+ * Checks if the next frame is due.
+ * @return True if a frame should be drawn.
+ */
+bool FrameScheduler::frameDue() const
+{
+	return _frame == Clock::duration::zero() || Clock::now() >= _nextFrame;
+}
+
+/**
+ * Records the time since the previous frame and schedules the next one.
+ * A frame drawn a bit late doesn't push back the ones after it, but
+ * falling behind by more than a whole frame starts a new cadence
+ * rather than rushing out frames to catch up.
+ */
+void FrameScheduler::frameDone()
+{
+	Clock::time_point now = Clock::now();
+	int frameTime = (int)std::chrono::duration_cast<std::chrono::microseconds>(now - _lastFrame).count();
+	if (_frameTimes.size() < FRAME_HISTORY)
+	{
+		_frameTimes.push_back(frameTime);
+	}
+	else
+	{
+		_frameTimes[_frameIndex] = frameTime;
+	}
+	_frameIndex = (_frameIndex + 1) % FRAME_HISTORY;
+	_lastFrame = now;
+
+	_nextFrame += _frame;
+	if (_nextFrame <= now)
+	{
+		_nextFrame = now + _frame;
+	}
+}
+
+/**
+ * Sleeps until the next logic tick or frame is due, whichever is first.
+ * Logic ticks only need millisecond accuracy. Before a frame, the sleep
+ * is cut short by the oversleep measured on previous ones and the rest
+ * is waited out by yielding the CPU.
+ */
+void FrameScheduler::wait()
+{
+	Clock::time_point now = Clock::now();
+	Clock::time_point nextTick = _lastTick + (_tick - _lag);
+	if (_frame == Clock::duration::zero() || nextTick <= _nextFrame)
+	{
+		if (nextTick > now)
+		{
+			auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(nextTick - now).count();
+			SDL_Delay((Uint32)std::max<decltype(ms)>(ms, 1));
+		}
+		return;
+	}
+
+	Clock::duration left = _nextFrame - now;
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(left - _slack);
+	if (ms.count() > 0)
+	{
+		SDL_Delay((Uint32)ms.count());
+		Clock::time_point woke = Clock::now();
+		// moving average of the oversleep
+		Clock::duration over = std::min<Clock::duration>((woke - now) - ms, MaxSlack);
+		_slack += (std::max(over, Clock::duration::zero()) - _slack) / 8;
+	}
+	while (Clock::now() < _nextFrame)
+	{
+		std::this_thread::yield();
+	}
+}
+
+/**
+ * Returns how many frame times are being kept.
+ * @return Number of frames.
+ */
+int FrameScheduler::getFrameCount() const
+{
+	return (int)_frameTimes.size();
+}
+
+/**
+ * Returns the time between frames that the given share of recent
+ * frames stayed within, eg. 0.5 is the median and 0.99 the time
+ * only the slowest 1% of frames went over.
+ * @param percentile Share of frames, from 0 to 1.
+ * @return Frame time in milliseconds.
+ */
+double FrameScheduler::getFrameTime(double percentile) const
+{
+	if (_frameTimes.empty())
+	{
+		return 0.0;
+	}
+	std::vector<int> sorted = _frameTimes;
+	size_t n = std::min(sorted.size() - 1, (size_t)(percentile * sorted.size()));
+	std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+	return sorted[n] / 1000.0;
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <vector>
+
+namespace OpenXcom
+{
+
+/**
+ * Paces the main loop. Game logic runs in fixed steps, as many as the
+ * real time since the last loop is worth, and frames are drawn on a
+ * fixed cadence of their own, independent of how long each loop takes.
+ * The loop sleeps until the next step or frame is due.
+ * Sleeps are shortened by the measured oversleep of the OS, and the
+ * rest of the wait before a frame is spent yielding, so frames go out
+ * on time without a busy loop.
+ * Also keeps the times between recent frames for statistics.
+ */
+class FrameScheduler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+private:
+	static const size_t FRAME_HISTORY = 256;
+	Clock::duration _tick, _frame, _slack, _lag;
+	Clock::time_point _lastTick, _nextFrame, _lastFrame;
+	std::vector<int> _frameTimes;
+	size_t _frameIndex;
+public:
+	/// Creates a scheduler with a logic tick rate.
+	FrameScheduler(int tickRate);
+	/// Sets the frame rate, 0 = unlimited.
+	void setFrameRate(int fps);
+	/// Checks if a logic tick is due, and takes it.
+	bool tickDue();
+	/// Checks if a frame is due.
+	bool frameDue() const;
+	/// Marks a frame as drawn.
+	void frameDone();
+	/// Sleeps until the next tick or frame is due.
+	void wait();
+	/// Gets the number of frames in the statistics.
+	int getFrameCount() const;
+	/// Gets a percentile of the recent frame times.
+	double getFrameTime(double percentile) const;
+};
+
+}
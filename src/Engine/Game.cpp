@@ -20,6 +20,7 @@
 #include "../resource.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <sstream>
 #include <SDL_mixer.h>
 #include "State.h"
@@ -30,6 +31,9 @@
 #include "Logger.h"
 #include "../Interface/Cursor.h"
 #include "../Interface/FpsCounter.h"
+#include "FrameScheduler.h"
+#include "FrameProfiler.h"
+#include "Timer.h"
 #include "../Mod/Mod.h"
 #include "../Savegame/SavedGame.h"
 #include "../Savegame/SavedBattleGame.h"
@@ -49,6 +53,8 @@
 namespace OpenXcom
 {
 
+// ticks per second, keeps the millisecond resolution the game timers were written for
+const int Game::LOGIC_TICK_RATE = 1000;
 const double Game::VOLUME_GRADIENT = 10.0;
 
 /**
@@ -56,8 +62,8 @@ const double Game::VOLUME_GRADIENT = 10.0;
  * creates the display screen and sets up the cursor.
  * @param title Title of the game window.
  */
-Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0), _mod(0), _quit(false), _init(false), _update(false),  _mouseActive(true), _timeUntilNextFrame(0),
-	_ctrl(false), _alt(false), _shift(false), _rmb(false), _mmb(false), _scrollStep(1)
+Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0), _mod(0), _quit(false), _init(false), _update(false),  _mouseActive(true), _frameScheduler(0),
+	_ctrl(false), _alt(false), _shift(false), _rmb(false), _mmb(false), _scrollStep(1), _backgroundCached(false)
 {
 	Options::reload = false;
 	Options::mute = false;
@@ -104,7 +110,7 @@ Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0
 	// Create blank language
 	_lang = new Language();
 
-	_timeOfLastFrame = 0;
+	_frameScheduler = new FrameScheduler(LOGIC_TICK_RATE);
 }
 
 /**
@@ -128,6 +134,7 @@ Game::~Game()
 	delete _mod;
 	delete _screen;
 	delete _fpsCounter;
+	delete _frameScheduler;
 
 	Mix_CloseAudio();
 
@@ -180,6 +187,7 @@ void Game::run()
 		}
 
 		// Process events
+		ProfileScope profileEvents(PHASE_EVENTS);
 		while (SDL_PollEvent(&_event))
 		{
 			if (CrossPlatform::isQuitShortcut(_event))
@@ -194,6 +202,8 @@ void Game::run()
 					if (reinterpret_cast<SDL_ActiveEvent*>(&_event)->state & ~SDL_APPMOUSEFOCUS)
 					{
 						Uint8 currentState = SDL_GetAppState();
+						// the window may have been covered or minimized
+						_screen->invalidate();
 						// Game is minimized
 						if (!(currentState & SDL_APPACTIVE))
 						{
@@ -223,6 +233,9 @@ void Game::run()
 						}
 					}
 					break;
+				case SDL_VIDEOEXPOSE:
+					_screen->invalidate();
+					break;
 				case SDL_VIDEORESIZE:
 					if (Options::allowResize)
 					{
@@ -238,6 +251,7 @@ void Game::run()
 								state->resize(dX, dY);
 							}
 							_screen->resetDisplay();
+							_backgroundCached = false;
 						}
 						else
 						{
@@ -327,31 +341,42 @@ void Game::run()
 				break;
 			}
 		}
+		profileEvents.stop();
 
 		// Process rendering
 		if (runningState != PAUSED)
 		{
-			// Process logic
-			_states.back()->think();
-			_fpsCounter->think();
+			// Process logic, one fixed step for each tick of real time since the last loop
+			{
+				ProfileScope profile(PHASE_THINK);
+				while (_frameScheduler->tickDue())
+				{
+					Timer::advanceGameTime(1000 / LOGIC_TICK_RATE);
+					_states.back()->think();
+					_fpsCounter->think();
+					if (!_init)
+					{
+						// States stack was changed, the new state
+						// must be initialized before it runs more ticks
+						break;
+					}
+				}
+			}
 			if (Options::FPS > 0 && !(Options::useOpenGL && Options::vSyncForOpenGL))
 			{
-				// Update our FPS delay time based on the time of the last draw.
-				int fps = SDL_GetAppState() & SDL_APPINPUTFOCUS ? Options::FPS : Options::FPSInactive;
-
-				_timeUntilNextFrame = (1000.0f / fps) - (SDL_GetTicks() - _timeOfLastFrame);
+				_frameScheduler->setFrameRate(SDL_GetAppState() & SDL_APPINPUTFOCUS ? Options::FPS : Options::FPSInactive);
 			}
 			else
 			{
-				_timeUntilNextFrame = 0;
+				// as fast as possible, or as fast as vsync lets us
+				_frameScheduler->setFrameRate(0);
 			}
 
-			if (_init && _timeUntilNextFrame <= 0)
+			if (_init && _frameScheduler->frameDue())
 			{
-				// make a note of when this frame update occurred.
-				_timeOfLastFrame = SDL_GetTicks();
 				_fpsCounter->addFrame();
-				_screen->clear();
+				ProfileScope profileBlit(PHASE_BLIT);
+				_screen->clearBuffer();
 				std::list<State*>::iterator i = _states.end();
 				do
 				{
@@ -359,13 +384,24 @@ void Game::run()
 				}
 				while (i != _states.begin() && !(*i)->isScreen());
 
+				if (Options::oxceCacheBackgroundStates && *i != _states.back())
+				{
+					blitBackground(i);
+					i = std::prev(_states.end());
+				}
 				for (; i != _states.end(); ++i)
 				{
 					(*i)->blit();
 				}
 				_fpsCounter->blit(_screen->getSurface());
 				_cursor->blit(_screen->getSurface());
-				_screen->flip();
+				profileBlit.stop();
+				{
+					ProfileScope profile(PHASE_FLIP);
+					_screen->flip();
+				}
+				_frameScheduler->frameDone();
+				FrameProfiler::endFrame();
 			}
 		}
 
@@ -373,13 +409,17 @@ void Game::run()
 		switch (runningState)
 		{
 			case RUNNING:
-				SDL_Delay(1); //Save CPU from going 100%
+				_frameScheduler->wait(); // sleep until the next tick or frame
 				break;
 			case SLOWED: case PAUSED:
 				SDL_Delay(100); break; //More slowing down.
 		}
 	}
 
+	if (_frameScheduler->getFrameCount() > 0)
+	{
+		Log(LOG_DEBUG) << "Frame times: median " << _frameScheduler->getFrameTime(0.5) << " ms, 99th percentile " << _frameScheduler->getFrameTime(0.99) << " ms";
+	}
 	Options::save();
 }
 
@@ -471,6 +511,7 @@ void Game::pushState(State *state)
 {
 	_states.push_back(state);
 	_init = false;
+	_backgroundCached = false;
 }
 
 /**
@@ -484,6 +525,46 @@ void Game::popState()
 	_deleted.push_back(_states.back());
 	_states.pop_back();
 	_init = false;
+	_backgroundCached = false;
+}
+
+/**
+ * Blits the states from the topmost full-screen one up to
+ * (but not including) the active state. Inactive states don't
+ * think, so their output is kept and copied back in on later
+ * frames, until the state stack changes or any of their surfaces
+ * move, change visibility or need a redraw.
+ * @param first Topmost full-screen state.
+ */
+void Game::blitBackground(std::list<State*>::iterator first)
+{
+	SDL_Surface *buffer = _screen->getSurface();
+	const size_t size = (size_t)buffer->pitch * buffer->h;
+	const std::list<State*>::iterator last = std::prev(_states.end());
+
+	_blitSignature.clear();
+	for (auto i = first; i != last; ++i)
+	{
+		(*i)->getBlitSignature(_blitSignature);
+	}
+	if (_backgroundCached && _background.size() == size && _blitSignature == _backgroundSignature)
+	{
+		memcpy(buffer->pixels, _background.data(), size);
+		return;
+	}
+
+	for (auto i = first; i != last; ++i)
+	{
+		(*i)->blit();
+	}
+	_background.assign((const Uint8*)buffer->pixels, (const Uint8*)buffer->pixels + size);
+	// blitting did the pending redraws, so take the signature again
+	_backgroundSignature.clear();
+	for (auto i = first; i != last; ++i)
+	{
+		(*i)->getBlitSignature(_backgroundSignature);
+	}
+	_backgroundCached = true;
 }
 
 /**
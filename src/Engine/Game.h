@@ -19,6 +19,7 @@
  */
 #include <list>
 #include <string>
+#include <vector>
 #include <SDL.h>
 
 namespace OpenXcom
@@ -32,6 +33,7 @@ class SavedGame;
 class Mod;
 class ModInfo;
 class FpsCounter;
+class FrameScheduler;
 class Action;
 class GeoscapeState;
 
@@ -54,12 +56,18 @@ private:
 	bool _quit, _init, _update;
 	FpsCounter *_fpsCounter;
 	bool _mouseActive;
-	unsigned int _timeOfLastFrame;
-	int _timeUntilNextFrame;
+	FrameScheduler *_frameScheduler;
 	bool _ctrl, _alt, _shift, _rmb, _mmb;
 	int _scrollStep;
+	std::vector<Uint8> _background;
+	std::vector<int> _backgroundSignature, _blitSignature;
+	bool _backgroundCached;
+	static const int LOGIC_TICK_RATE;
 	static const double VOLUME_GRADIENT;
 
+	/// Blits the inactive states under the active one.
+	void blitBackground(std::list<State*>::iterator first);
+
 public:
 	/// Creates a new game and initializes SDL.
 	Game(const std::string &title);
@@ -79,6 +87,8 @@ public:
 	Cursor *getCursor() const { return _cursor; }
 	/// Gets the FpsCounter.
 	FpsCounter *getFpsCounter() const { return _fpsCounter; }
+	/// Gets the main loop pacing and frame statistics.
+	FrameScheduler *getFrameScheduler() const { return _frameScheduler; }
 	/// Resets the state stack to a new state.
 	void setState(State *state);
 	/// Pushes a new state into the state stack.
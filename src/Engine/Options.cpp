@@ -31,6 +31,7 @@
 #include "Exception.h"
 #include "Logger.h"
 #include "CrossPlatform.h"
+#include "AsyncLog.h"
 #include "../Menu/ModConfirmExtendedState.h"
 #include "FileMap.h"
 #include "Screen.h"
@@ -56,6 +57,7 @@ std::string _masterMod;
 int _passwordCheck = -1;
 bool _loadLastSave = false;
 std::string _loadThisSave = "";
+std::string _traceFile;
 bool _loadLastSaveExpended = false;
 
 /**
@@ -368,6 +370,14 @@ void createOptionsOXCE()
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceThumbButtons", &oxceThumbButtons, true));
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceThrottleMouseMoveEvent", &oxceThrottleMouseMoveEvent, 0));
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceDisableThinkingProgressBar", &oxceDisableThinkingProgressBar, false));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceWorkerThreads", &oxceWorkerThreads, 0));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceMapTerrainCache", &oxceMapTerrainCache, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceMapDrawThreads", &oxceMapDrawThreads, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceUnitSpriteCacheSize", &oxceUnitSpriteCacheSize, 4096));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceScreenDirtyRects", &oxceScreenDirtyRects, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceCacheBackgroundStates", &oxceCacheBackgroundStates, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceFrameProfiler", &oxceFrameProfiler, false));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceAsyncLogging", &oxceAsyncLogging, true));
 
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceEmbeddedOnly", &oxceEmbeddedOnly, true));
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceListVFSContents", &oxceListVFSContents, false));
@@ -705,6 +715,10 @@ static void loadArgs()
 					_loadLastSave = true;
 					_loadThisSave = argv[i];
 				}
+				else if (argname == "trace")
+				{
+					_traceFile = argv[i];
+				}
 				else
 				{
 					//save this command line option for now, we will apply it later
@@ -743,6 +757,8 @@ static bool showHelp()
 	help << "        load last save" << std::endl << std::endl;
 	help << "-load FILENAME" << std::endl;
 	help << "        load the specified FILENAME (from the corresponding master mod subfolder)" << std::endl << std::endl;
+	help << "-trace FILENAME" << std::endl;
+	help << "        record a timeline of the game's inner workings to FILENAME (trace event JSON, for chrome://tracing or Perfetto)" << std::endl << std::endl;
 	help << "-version" << std::endl;
 	help << "        show version number" << std::endl << std::endl;
 	help << "-help" << std::endl;
@@ -842,6 +858,8 @@ bool init()
 
 	// this enables writes to the log file and filters already emitted messages
 	CrossPlatform::setLogFileName(getUserFolder() + "openxcom.log");
+	if (Options::oxceAsyncLogging)
+		AsyncLog::start(getUserFolder() + "openxcom.log");
 
 	Log(LOG_INFO) << "OpenXcom Version: " << OPENXCOM_VERSION_SHORT << OPENXCOM_VERSION_GIT;
 #ifdef _WIN64
@@ -1150,6 +1168,15 @@ const std::string& getLoadThisSave()
 	return _loadThisSave;
 }
 
+/**
+ * Gets the file to record a trace to.
+ * @return File path, empty for no tracing.
+ */
+const std::string& getTraceFile()
+{
+	return _traceFile;
+}
+
 void expendLoadLastSave()
 {
 	_loadLastSaveExpended = true;
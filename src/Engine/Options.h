@@ -133,6 +133,8 @@ namespace Options
 	bool getLoadLastSave();
 	/// If we should skip the main menu and just load the specified save
 	const std::string& getLoadThisSave();
+	/// Gets the file to record a trace to, if any.
+	const std::string& getTraceFile();
 	/// And do it only at startup
 	void expendLoadLastSave();
 }
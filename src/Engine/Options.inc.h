@@ -121,6 +121,14 @@ OPT bool oxceFirstPersonViewFisheyeProjection;
 OPT bool oxceThumbButtons;
 OPT int oxceThrottleMouseMoveEvent;
 OPT bool oxceDisableThinkingProgressBar;
+OPT int oxceWorkerThreads;
+OPT bool oxceMapTerrainCache;
+OPT bool oxceMapDrawThreads;
+OPT int oxceUnitSpriteCacheSize;
+OPT bool oxceScreenDirtyRects;
+OPT bool oxceCacheBackgroundStates;
+OPT bool oxceFrameProfiler;
+OPT bool oxceAsyncLogging;
 
 OPT bool oxceEmbeddedOnly;
 OPT bool oxceListVFSContents;
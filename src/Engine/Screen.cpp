@@ -33,6 +33,7 @@
 #include "FileMap.h"
 #include "Zoom.h"
 #include "Timer.h"
+#include "FrameProfiler.h"
 #include <SDL.h>
 #include <algorithm>
 
@@ -112,7 +113,7 @@ void Screen::makeVideoFlags()
  * Initializes a new display screen for the game to render contents to.
  * The screen is set up based on the current options.
  */
-Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _flickerFix(false)
+Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _flickerFix(false), _fullFlip(true), _paletteChanged(false)
 {
 	_flickerFix = Options::oxceEnablePaletteFlickerFix;
 
@@ -181,15 +182,155 @@ void Screen::handle(Action *action)
 }
 
 
+/**
+ * Compares the buffer with the copy of the last flipped frame and
+ * collects the changed areas, in bands of a few rows each, updating
+ * the copy along the way.
+ */
+void Screen::findDirtyRects()
+{
+	const int bandRows = 8;
+	const int bpp = _surface->format->BytesPerPixel;
+	const int pitch = _surface->pitch;
+	const int rowBytes = _surface->w * bpp;
+	const Uint8 *pixels = (const Uint8*)_surface->pixels;
+
+	_dirtyRects.clear();
+	for (int band = 0; band < _surface->h; band += bandRows)
+	{
+		const int bandEnd = std::min(band + bandRows, _surface->h);
+		int minX = rowBytes, maxX = -1;
+		for (int y = band; y < bandEnd; ++y)
+		{
+			const Uint8 *now = pixels + y * pitch;
+			Uint8 *last = &_lastFrame[y * pitch];
+			if (memcmp(now, last, rowBytes) == 0)
+			{
+				continue;
+			}
+			int first = 0, end = rowBytes;
+			while (now[first] == last[first])
+			{
+				++first;
+			}
+			while (now[end - 1] == last[end - 1])
+			{
+				--end;
+			}
+			minX = std::min(minX, first);
+			maxX = std::max(maxX, end);
+			memcpy(last + first, now + first, end - first);
+		}
+		if (maxX < 0)
+		{
+			continue;
+		}
+
+		SDL_Rect r;
+		r.x = minX / bpp;
+		r.y = band;
+		r.w = (maxX + bpp - 1) / bpp - r.x;
+		r.h = bandEnd - band;
+		// join with the band above when it changed too
+		if (!_dirtyRects.empty() && _dirtyRects.back().y + _dirtyRects.back().h == band)
+		{
+			SDL_Rect &prev = _dirtyRects.back();
+			int x1 = std::max(prev.x + prev.w, r.x + r.w);
+			prev.x = std::min(prev.x, r.x);
+			prev.w = x1 - prev.x;
+			prev.h += r.h;
+		}
+		else
+		{
+			_dirtyRects.push_back(r);
+		}
+	}
+}
+
+/**
+ * Grows a changed rectangle of the buffer to cover the pixels
+ * the scaling filters blend it into, they change along with it.
+ * @param rect Buffer rectangle.
+ * @return Grown rectangle, still inside the buffer.
+ */
+SDL_Rect Screen::getFilterRect(const SDL_Rect &rect) const
+{
+	const int margin = 2;
+	int x0 = std::max(rect.x - margin, 0);
+	int y0 = std::max(rect.y - margin, 0);
+	int x1 = std::min(rect.x + rect.w + margin, _surface->w);
+	int y1 = std::min(rect.y + rect.h + margin, _surface->h);
+
+	SDL_Rect r;
+	r.x = x0;
+	r.y = y0;
+	r.w = x1 - x0;
+	r.h = y1 - y0;
+	return r;
+}
+
+/**
+ * Converts a rectangle of the buffer to the rectangle of
+ * the display it ends up in after zooming.
+ * @param rect Buffer rectangle.
+ * @return Display rectangle.
+ */
+SDL_Rect Screen::getDisplayRect(const SDL_Rect &rect) const
+{
+	const int dstWidth = _screen->w - _leftBlackBand - _rightBlackBand;
+	const int dstHeight = _screen->h - _topBlackBand - _bottomBlackBand;
+	int x0 = rect.x * dstWidth / _surface->w;
+	int y0 = rect.y * dstHeight / _surface->h;
+	int x1 = ((rect.x + rect.w) * dstWidth + _surface->w - 1) / _surface->w;
+	int y1 = ((rect.y + rect.h) * dstHeight + _surface->h - 1) / _surface->h;
+
+	SDL_Rect r;
+	r.x = _leftBlackBand + x0;
+	r.y = _topBlackBand + y0;
+	r.w = x1 - x0;
+	r.h = y1 - y0;
+	return r;
+}
+
 /**
  * Renders the buffer's contents onto the screen, applying
  * any necessary filters or conversions in the process.
  * If the scaling factor is bigger than 1, the entire contents
  * of the buffer are resized by that factor (eg. 2 = doubled)
  * before being put on screen.
+ * Only the parts that changed since the last flip are converted,
+ * scaled and sent to the display, and nothing at all if the frame is the same.
  */
 void Screen::flip()
 {
+	const size_t frameSize = (size_t)_surface->pitch * _surface->h;
+	if (Options::oxceScreenDirtyRects && !_fullFlip && !_paletteChanged && _lastFrame.size() == frameSize)
+	{
+		findDirtyRects();
+		if (_dirtyRects.empty())
+		{
+			return;
+		}
+	}
+	else
+	{
+		_dirtyRects.clear();
+		if (Options::oxceScreenDirtyRects)
+		{
+			_lastFrame.assign((const Uint8*)_surface->pixels, (const Uint8*)_surface->pixels + frameSize);
+		}
+		else
+		{
+			_lastFrame.clear();
+		}
+	}
+	_fullFlip = false;
+	_paletteChanged = false;
+	// hardware page flipping swaps between two buffers and OpenGL always uploads the whole texture,
+	// so they need the whole frame every time
+	const bool partial = !_dirtyRects.empty() && (_screen->flags & SDL_DOUBLEBUF) != SDL_DOUBLEBUF && !useOpenGL();
+	const bool zoom = getWidth() != _baseWidth || getHeight() != _baseHeight || useOpenGL();
+
 	// perform any requested palette update
 	if (_flickerFix && _pushPalette && _numColors && _screen->format->BitsPerPixel == 8)
 	{
@@ -201,14 +342,31 @@ void Screen::flip()
 		_pushPalette = false;
 	}
 
-	if (getWidth() != _baseWidth || getHeight() != _baseHeight || useOpenGL())
+	ProfileScope profileScaling(PHASE_SCALING);
+	if (zoom)
 	{
-		Zoom::flipWithZoom(_surface.get(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput);
+		if (partial)
+		{
+			for (auto &rect : _dirtyRects)
+			{
+				rect = getFilterRect(rect);
+			}
+		}
+		Zoom::flipWithZoom(_surface.get(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput, partial ? &_dirtyRects : nullptr);
+	}
+	else if (partial)
+	{
+		for (const auto &rect : _dirtyRects)
+		{
+			SDL_Rect srcRect = rect, dstRect = rect;
+			SDL_BlitSurface(_surface.get(), &srcRect, _screen, &dstRect);
+		}
 	}
 	else
 	{
 		SDL_BlitSurface(_surface.get(), 0, _screen, 0);
 	}
+	profileScaling.stop();
 
 	// perform any requested palette update
 	if (!_flickerFix && _pushPalette && _numColors && _screen->format->BitsPerPixel == 8)
@@ -221,9 +379,19 @@ void Screen::flip()
 		_pushPalette = false;
 	}
 
-
-
-	if (SDL_Flip(_screen) == -1)
+	ProfileScope profileFlip(PHASE_SDL_FLIP);
+	if (partial)
+	{
+		if (zoom)
+		{
+			for (auto &rect : _dirtyRects)
+			{
+				rect = getDisplayRect(rect);
+			}
+		}
+		SDL_UpdateRects(_screen, (int)_dirtyRects.size(), _dirtyRects.data());
+	}
+	else if (SDL_Flip(_screen) == -1)
 	{
 		throw Exception(SDL_GetError());
 	}
@@ -236,6 +404,25 @@ void Screen::clear()
 {
 	Surface::CleanSdlSurface(_surface.get());
 	Surface::CleanSdlSurface(_screen);
+	_fullFlip = true;
+}
+
+/**
+ * Clears the internal buffer, leaving what's on the display
+ * for the next flip to update.
+ */
+void Screen::clearBuffer()
+{
+	Surface::CleanSdlSurface(_surface.get());
+}
+
+/**
+ * Makes the next flip send the whole buffer to the display,
+ * for when the window contents were lost.
+ */
+void Screen::invalidate()
+{
+	_fullFlip = true;
 }
 
 /**
@@ -263,6 +450,7 @@ void Screen::setPalette(const SDL_Color* colors, int firstcolor, int ncolors, bo
 	}
 
 	SDL_SetColors(_surface.get(), const_cast<SDL_Color *>(colors), firstcolor, ncolors);
+	_paletteChanged = true;
 
 	// defer actual update of screen until SDL_Flip()
 	if (immediately && _screen->format->BitsPerPixel == 8 && SDL_SetColors(_screen, const_cast<SDL_Color *>(colors), firstcolor, ncolors) == 0)
@@ -497,6 +685,7 @@ void Screen::resetDisplay(bool resetVideo, bool noShaders)
 	{
 		setPalette(getPalette());
 	}
+	_fullFlip = true;
 }
 
 /**
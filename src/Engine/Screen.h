@@ -19,6 +19,7 @@
  */
 #include <SDL.h>
 #include <string>
+#include <vector>
 #include "OpenGL.h"
 #include "Surface.h"
 
@@ -52,8 +53,17 @@ private:
 	OpenGL glOutput;
 	Surface::UniqueBufferPtr _buffer;
 	Surface::UniqueSurfacePtr _surface;
+	std::vector<Uint8> _lastFrame;
+	std::vector<SDL_Rect> _dirtyRects;
+	bool _fullFlip, _paletteChanged;
 	/// Sets the _flags and _bpp variables based on game options; needed in more than one place now
 	void makeVideoFlags();
+	/// Finds the parts of the buffer changed since the last flip.
+	void findDirtyRects();
+	/// Grows a buffer rectangle by what the scaling filters blend it into.
+	SDL_Rect getFilterRect(const SDL_Rect &rect) const;
+	/// Converts a buffer rectangle to the display rectangle it's shown in.
+	SDL_Rect getDisplayRect(const SDL_Rect &rect) const;
 public:
 	static const int ORIGINAL_WIDTH;
 	static const int ORIGINAL_HEIGHT;
@@ -74,6 +84,10 @@ public:
 	void flip();
 	/// Clears the screen.
 	void clear();
+	/// Clears the internal buffer only.
+	void clearBuffer();
+	/// Makes the next flip render the whole screen.
+	void invalidate();
 	/// Sets the screen's 8bpp palette.
 	void setPalette(const SDL_Color *colors, int firstcolor = 0, int ncolors = 256, bool immediately = false);
 	/// Gets the screen's 8bpp palette.
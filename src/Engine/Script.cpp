@@ -501,6 +501,97 @@ static inline void scriptExe(ScriptWorkerBase& data, const Uint8* proc)
 //						Script class
 ////////////////////////////////////////////////////////////
 
+/**
+ * Test if script or any of its events use given register.
+ * @param reg register to check.
+ * @return true if any code read or write this register.
+ */
+bool ScriptContainerEventsBase::isRegUsed(RegEnum reg) const
+{
+	if (_current.isRegUsed(reg))
+	{
+		return true;
+	}
+	if (auto ptr = _events)
+	{
+		// two lists of events, before and after the main script, each one ends with an empty script
+		for (int i = 0; i < 2; ++i, ++ptr)
+		{
+			for (; *ptr; ++ptr)
+			{
+				if (ptr->isRegUsed(reg))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * Test if script or any of its events have any code.
+ * @return false if running it would do nothing.
+ */
+bool ScriptContainerEventsBase::hasCode() const
+{
+	if (_current)
+	{
+		return true;
+	}
+	if (auto ptr = _events)
+	{
+		// two lists of events, before and after the main script, each one ends with an empty script
+		for (int i = 0; i < 2; ++i, ++ptr)
+		{
+			if (*ptr)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * Run script for one pixel.
+ * @param src source pixel.
+ * @param dest destination pixel.
+ * @return new value of destination pixel, 0 means that it is unchanged.
+ */
+int ScriptWorkerBlit::executePixel(int src, int dest)
+{
+	ScriptWorkerBlit::Output arg = { src, dest };
+	set(arg);
+	if (_events)
+	{
+		auto ptr = _events;
+		while (*ptr)
+		{
+			reset(arg);
+			scriptExe(*this, ptr->data());
+			++ptr;
+		}
+		++ptr;
+
+		reset(arg);
+		scriptExe(*this, _proc);
+
+		while (*ptr)
+		{
+			reset(arg);
+			scriptExe(*this, ptr->data());
+			++ptr;
+		}
+	}
+	else
+	{
+		scriptExe(*this, _proc);
+	}
+	get(arg);
+	return arg.getFirst();
+}
+
 void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int y, int shade)
 {
 	executeBlit(src, dest, x, y, shade, GraphSubset{ dest->getWidth(), dest->getHeight() } );
@@ -519,7 +610,30 @@ void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int
 
 	destShader.setDomain(mask);
 
-	if (_proc)
+	if (_proc && !_destUsed)
+	{
+		// the script only see the source pixel and values that are constant for the whole blit,
+		// so it is enough to run it once for each color present in source
+		int colors[256];
+		bool colorsDone[256] = { };
+		ShaderDrawFunc(
+			[&](Uint8& destStuff, const Uint8& srcStuff)
+			{
+				if (srcStuff)
+				{
+					if (!colorsDone[srcStuff])
+					{
+						colors[srcStuff] = executePixel(srcStuff, destStuff);
+						colorsDone[srcStuff] = true;
+					}
+					if (colors[srcStuff]) destStuff = colors[srcStuff];
+				}
+			},
+			destShader,
+			srcShader
+		);
+	}
+	else if (_proc)
 	{
 		if (_events)
 		{
@@ -3168,6 +3282,7 @@ bool ParserWriter::pushRegTry(const ScriptRefData& data, ArgEnum type)
 	type = ArgSpecAdd(type, ArgSpecReg);
 	if (data && ArgCompatible(type, data.type, 0) && data.getValue<RegEnum>() != RegInvalid)
 	{
+		container._regUsed.set(data.getValue<RegEnum>());
 		pushValue(data.getValue<RegEnum>());
 		return true;
 	}
@@ -5036,6 +5151,22 @@ static auto dummyTestScriptOverloadSeperator = ([]
 	return 0;
 })();
 
+[[maybe_unused]]
+static auto dummyTestScriptRegUsed = ([]
+{
+	TestEnv env;
+	ParserWriter& help = env.help;
+	auto arg_x = help.addReg<int&>(ScriptRef{"x"});
+	auto arg_y = help.addReg<int&>(ScriptRef{"y"});
+
+	assert(!env.tempScript.isRegUsed(arg_x.getValue<RegEnum>()));
+	assert(help.pushRegTry<int>(arg_x));
+	assert(env.tempScript.isRegUsed(arg_x.getValue<RegEnum>()) && "x used");
+	assert(!env.tempScript.isRegUsed(arg_y.getValue<RegEnum>()) && "y not used");
+
+	return 0;
+})();
+
 
 [[maybe_unused]]
 static auto dummyTestScriptRefTokens = ([]
@@ -20,6 +20,7 @@
 #include <map>
 #include <limits>
 #include <vector>
+#include <bitset>
 #include <string>
 #include <cstring>
 #include "../Engine/Yaml.h"
@@ -392,6 +393,7 @@ class ScriptContainerBase
 {
 	friend struct ParserWriter;
 	std::vector<Uint8> _proc;
+	std::bitset<ScriptMaxReg> _regUsed;
 
 public:
 	/// Constructor.
@@ -420,6 +422,11 @@ public:
 	{
 		return *this ? _proc.data() : nullptr;
 	}
+	/// Test if script code use given register.
+	bool isRegUsed(RegEnum reg) const
+	{
+		return _regUsed.test(reg);
+	}
 };
 
 /**
@@ -467,6 +474,10 @@ public:
 	{
 		return _events;
 	}
+	/// Test if script or any of its events use given register.
+	bool isRegUsed(RegEnum reg) const;
+	/// Test if script or any of its events have any code.
+	bool hasCode() const;
 };
 
 /**
@@ -693,6 +704,13 @@ class ScriptWorkerBase
 	}
 
 protected:
+	/// Get register of output argument.
+	template<typename... Args>
+	static constexpr RegEnum outputReg(helper::TypeTag<ScriptOutputArgs<Args...>>, int i)
+	{
+		return static_cast<RegEnum>(offset<void, Args...>(i, 0));
+	}
+
 	/// Update values in script.
 	template<typename Output, typename... Args>
 	void updateBase(Args... args)
@@ -819,16 +837,23 @@ public:
  */
 class ScriptWorkerBlit : public ScriptWorkerBase
 {
+public:
+	/// Type of output value from script.
+	using Output = ScriptOutputArgs<int&, int>;
+
+private:
 	/// Current script set in worker.
 	const Uint8* _proc;
 	const ScriptContainerBase* _events;
+	/// Script reads destination pixel.
+	bool _destUsed;
 
-public:
-	/// Type of output value from script.
-	using Output = ScriptOutputArgs<int&, int>;
+	/// Register of destination pixel.
+	static constexpr RegEnum DestReg = outputReg(helper::TypeTag<Output>{}, 1);
 
+public:
 	/// Default constructor.
-	ScriptWorkerBlit() : ScriptWorkerBase(), _proc(nullptr), _events(nullptr)
+	ScriptWorkerBlit() : ScriptWorkerBase(), _proc(nullptr), _events(nullptr), _destUsed(false)
 	{
 
 	}
@@ -843,6 +868,7 @@ public:
 		{
 			_proc = c.data();
 			_events = nullptr;
+			_destUsed = c.isRegUsed(DestReg);
 			updateBase<Output>(args...);
 		}
 	}
@@ -857,10 +883,24 @@ public:
 		{
 			_proc = c.data();
 			_events = c.dataEvents();
+			_destUsed = c.isRegUsed(DestReg);
 			updateBase<Output>(args...);
 		}
 	}
 
+	/// Checks if there is any script set in worker.
+	bool hasScript() const
+	{
+		return _proc;
+	}
+	/// Checks if the result of the script depends on the destination pixel.
+	bool isDestUsed() const
+	{
+		return _destUsed;
+	}
+
+	/// Run script for one pixel.
+	int executePixel(int src, int dest);
 	/// Programmable blitting using script.
 	void executeBlit(const Surface* src, Surface* dest, int x, int y, int shade);
 	/// Programmable blitting using script.
@@ -871,6 +911,7 @@ public:
 	{
 		_proc = nullptr;
 		_events = nullptr;
+		_destUsed = false;
 	}
 };
 
@@ -356,6 +356,25 @@ void State::blit()
 	}
 }
 
+/**
+ * Adds the position, visibility and draw counter of all the Surface
+ * child elements to a signature, along with any pending redraws.
+ * While the signature stays the same, so does the blitted output
+ * (as long as the state isn't thinking). States that blit more
+ * than their own surfaces must add those too.
+ * @param signature List of values to add to.
+ */
+void State::getBlitSignature(std::vector<int> &signature) const
+{
+	for (auto* surface : _surfaces)
+	{
+		signature.push_back(surface->getX());
+		signature.push_back(surface->getY());
+		signature.push_back(surface->getVisible() | surface->getHidden() << 1 | surface->getRedraw() << 2);
+		signature.push_back((int)surface->getDrawCount());
+	}
+}
+
 /**
  * Hides all the Surface child elements on display.
  */
@@ -87,6 +87,8 @@ public:
 	virtual void think();
 	/// Blits the state to the screen.
 	virtual void blit();
+	/// Adds what the blitted output depends on to a signature.
+	virtual void getBlitSignature(std::vector<int> &signature) const;
 	/// Hides all the state surfaces.
 	void hideAll();
 	/// Shows all the state surfaces.
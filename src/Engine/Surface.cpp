@@ -227,7 +227,7 @@ void Surface::UniqueSurfaceDeleter::operator ()(SDL_Surface* surf)
 /**
  * Default empty surface.
  */
-Surface::Surface() : _x{ }, _y{ }, _width{ }, _height{ }, _pitch{ }, _visible(true), _hidden(false), _redraw(false)
+Surface::Surface() : _x{ }, _y{ }, _width{ }, _height{ }, _pitch{ }, _drawCount(0), _visible(true), _hidden(false), _redraw(false)
 {
 
 }
@@ -244,7 +244,7 @@ Surface::Surface() : _x{ }, _y{ }, _width{ }, _height{ }, _pitch{ }, _visible(tr
  * @param y Y position in pixels.
  * @param bpp Bits-per-pixel depth.
  */
-Surface::Surface(int width, int height, int x, int y) : _x(x), _y(y), _visible(true), _hidden(false), _redraw(false)
+Surface::Surface(int width, int height, int x, int y) : _x(x), _y(y), _drawCount(0), _visible(true), _hidden(false), _redraw(false)
 {
 	std::tie(_alignedBuffer, _surface) = Surface::NewPair8Bit(width, height);
 	_width = _surface->w;
@@ -536,6 +536,7 @@ void Surface::loadBdy(const std::string &filename)
  */
 void Surface::clear()
 {
+	++_drawCount;
 	CleanSdlSurface(_surface.get());
 }
 
@@ -758,6 +759,7 @@ void Surface::copy(Surface *surface)
  */
 void Surface::drawRect(SDL_Rect *rect, Uint8 color)
 {
+	++_drawCount;
 	if (rect->w == 0 || rect->h == 0) return;
 
 	SDL_FillRect(_surface.get(), rect, color);
@@ -773,6 +775,7 @@ void Surface::drawRect(SDL_Rect *rect, Uint8 color)
  */
 void Surface::drawRect(Sint16 x, Sint16 y, Sint16 w, Sint16 h, Uint8 color)
 {
+	++_drawCount;
 	if (w == 0 || h == 0) return;
 
 	SDL_Rect rect;
@@ -793,6 +796,7 @@ void Surface::drawRect(Sint16 x, Sint16 y, Sint16 w, Sint16 h, Uint8 color)
  */
 void Surface::drawLine(Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 color)
 {
+	++_drawCount;
 	lineColor(_surface.get(), x1, y1, x2, y2, Palette::getRGBA(getPalette(), color));
 }
 
@@ -805,6 +809,7 @@ void Surface::drawLine(Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 color)
  */
 void Surface::drawCircle(Sint16 x, Sint16 y, Sint16 r, Uint8 color)
 {
+	++_drawCount;
 	filledCircleColor(_surface.get(), x, y, r, Palette::getRGBA(getPalette(), color));
 }
 
@@ -817,6 +822,7 @@ void Surface::drawCircle(Sint16 x, Sint16 y, Sint16 r, Uint8 color)
  */
 void Surface::drawPolygon(Sint16 *x, Sint16 *y, int n, Uint8 color)
 {
+	++_drawCount;
 	filledPolygonColor(_surface.get(), x, y, n, Palette::getRGBA(getPalette(), color));
 }
 
@@ -831,6 +837,7 @@ void Surface::drawPolygon(Sint16 *x, Sint16 *y, int n, Uint8 color)
  */
 void Surface::drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture, int dx, int dy)
 {
+	++_drawCount;
 	texturedPolygon(_surface.get(), x, y, n, texture->getSurface(), dx, dy);
 }
 
@@ -843,6 +850,7 @@ void Surface::drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture,
  */
 void Surface::drawString(Sint16 x, Sint16 y, const char *s, Uint8 color)
 {
+	++_drawCount;
 	stringColor(_surface.get(), x, y, s, Palette::getRGBA(getPalette(), color));
 }
 
@@ -883,6 +891,25 @@ bool Surface::getVisible() const
 	return _visible;
 }
 
+/**
+ * Returns the temporary visibility setting of the surface.
+ * @return Is the surface hidden?
+ */
+bool Surface::getHidden() const
+{
+	return _hidden;
+}
+
+/**
+ * Returns whether the surface contents changed and
+ * will be redrawn the next time it's blitted.
+ * @return Is a redraw pending?
+ */
+bool Surface::getRedraw() const
+{
+	return _redraw;
+}
+
 /**
  * Returns the cropping rectangle for this surface.
  * @return Pointer to the cropping rectangle.
@@ -900,6 +927,7 @@ SurfaceCrop Surface::getCrop() const
  */
 void Surface::setPalette(const SDL_Color *colors, int firstcolor, int ncolors)
 {
+	++_drawCount;
 	if (_surface->format->BitsPerPixel == 8)
 		SDL_SetColors(_surface.get(), const_cast<SDL_Color *>(colors), firstcolor, ncolors);
 }
@@ -924,6 +952,7 @@ void Surface::setHidden(bool hidden)
  */
 void Surface::lock()
 {
+	++_drawCount;
 	SDL_LockSurface(_surface.get());
 }
 
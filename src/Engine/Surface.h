@@ -22,6 +22,7 @@
 #include <vector>
 #include <memory>
 #include <vector>
+#include <type_traits>
 #include <assert.h>
 #include "GraphSubset.h"
 
@@ -86,6 +87,7 @@ protected:
 	UniqueSurfacePtr _surface;
 	Sint16 _x, _y;
 	Uint16 _width, _height, _pitch;
+	Uint32 _drawCount;
 	Uint8 _visible: 1;
 	Uint8 _hidden: 1;
 	Uint8 _redraw: 1;
@@ -195,6 +197,19 @@ public:
 	virtual void setVisible(bool visible);
 	/// Gets the surface's visibility.
 	bool getVisible() const;
+	/// Gets the surface's temporary visibility.
+	bool getHidden() const;
+	/// Gets if the surface will be redrawn on the next blit.
+	bool getRedraw() const;
+	/**
+	 * Returns how many times the surface could have been drawn to,
+	 * counting every write access to its pixels or palette.
+	 * @return Draw counter.
+	 */
+	Uint32 getDrawCount() const
+	{
+		return _drawCount;
+	}
 	/// Gets the cropping rectangle for the surface.
 	SurfaceCrop getCrop() const;
 	/**
@@ -270,6 +285,7 @@ public:
 	 */
 	SDL_Surface *getSurface()
 	{
+		++_drawCount;
 		return _surface.get();
 	}
 	/**
@@ -300,6 +316,7 @@ public:
 	/// Get pointer to buffer
 	Uint8* getBuffer()
 	{
+		++_drawCount;
 		return _alignedBuffer.get();
 	}
 	/// Get pointer to buffer
@@ -374,7 +391,9 @@ public:
 	{
 		if (surf)
 		{
-			*this = SurfaceRaw{ surf->getBuffer(), surf->getWidth(), surf->getHeight(), surf->getPitch() };
+			// read only access doesn't count as drawing to the surface
+			using SurfacePtr = typename std::conditional<std::is_const<Pixel>::value, const Surface*, Surface*>::type;
+			*this = SurfaceRaw{ static_cast<SurfacePtr>(surf)->getBuffer(), surf->getWidth(), surf->getHeight(), surf->getPitch() };
 		}
 	}
 
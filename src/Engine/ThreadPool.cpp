@@ -0,0 +1,221 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Options.h"
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+const int MaxThreads = 16;
+
+/// Serializes jobs started by different threads.
+std::mutex callerMutex;
+/// Protects everything below.
+std::mutex stateMutex;
+std::condition_variable wakeWorkers;
+std::condition_variable jobDone;
+std::vector<std::thread> workers;
+const std::function<void(int)> *job = nullptr;
+int jobCount = 0;
+std::atomic<int> nextIndex(0);
+int busyWorkers = 0;
+unsigned generation = 0;
+bool stopping = false;
+std::exception_ptr jobError;
+
+/// Set on threads currently running a job, nested jobs run inline.
+thread_local bool insideJob = false;
+
+/**
+ * Takes indexes of the current job until there are none left.
+ * The first exception stops the job and is kept for the caller.
+ * @param func Job.
+ * @param count Number of indexes.
+ */
+void runJob(const std::function<void(int)> &func, int count)
+{
+	insideJob = true;
+	for (int i = nextIndex++; i < count; i = nextIndex++)
+	{
+		try
+		{
+			func(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(stateMutex);
+			if (!jobError)
+			{
+				jobError = std::current_exception();
+			}
+			nextIndex = count;
+		}
+	}
+	insideJob = false;
+}
+
+/**
+ * Main loop of a worker thread: waits for a new job generation and helps with it.
+ */
+void workerLoop()
+{
+	unsigned seen = 0;
+	std::unique_lock<std::mutex> lock(stateMutex);
+	while (true)
+	{
+		wakeWorkers.wait(lock, [&]{ return stopping || generation != seen; });
+		if (stopping)
+		{
+			return;
+		}
+		seen = generation;
+		if (!job)
+		{
+			continue; // woke up too late, the caller already finished it
+		}
+		const std::function<void(int)> *func = job;
+		int count = jobCount;
+		++busyWorkers;
+		lock.unlock();
+		runJob(*func, count);
+		lock.lock();
+		if (--busyWorkers == 0)
+		{
+			jobDone.notify_all();
+		}
+	}
+}
+
+/**
+ * Gets the number of threads the options ask for.
+ * @return Thread count, at least 1.
+ */
+int getWantedThreads()
+{
+	int wanted = Options::oxceWorkerThreads;
+	if (wanted <= 0)
+	{
+		wanted = (int)std::thread::hardware_concurrency();
+	}
+	return std::max(1, std::min(wanted, MaxThreads));
+}
+
+}
+
+/**
+ * Runs a function for every index of a range, using all the worker threads.
+ * The calling thread takes part in the job, and it returns once every index
+ * is done. Calls made from inside a job run on the calling thread only.
+ * If any call throws, the remaining indexes are skipped and
+ * the first exception is rethrown on the calling thread.
+ * @param count Number of indexes.
+ * @param func Function to call with each index, in no particular order.
+ */
+void ThreadPool::parallelFor(int count, const std::function<void(int)> &func)
+{
+	if (count <= 1 || insideJob || getThreadCount() <= 1)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			func(i);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> caller(callerMutex);
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		if (workers.empty())
+		{
+			int threads = getWantedThreads();
+			for (int i = 1; i < threads; ++i)
+			{
+				workers.emplace_back(workerLoop);
+			}
+		}
+		job = &func;
+		jobCount = count;
+		nextIndex = 0;
+		jobError = nullptr;
+		++generation;
+	}
+	wakeWorkers.notify_all();
+
+	runJob(func, count);
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(stateMutex);
+		jobDone.wait(lock, []{ return busyWorkers == 0; });
+		job = nullptr;
+		error = jobError;
+		jobError = nullptr;
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+/**
+ * Gets how many threads work on a job, the caller included.
+ * Useful to split work in roughly even parts.
+ * @return Number of threads.
+ */
+int ThreadPool::getThreadCount()
+{
+	std::lock_guard<std::mutex> lock(stateMutex);
+	if (!workers.empty())
+	{
+		return (int)workers.size() + 1;
+	}
+	return getWantedThreads();
+}
+
+/**
+ * Stops all the worker threads, they are started again by the next job.
+ */
+void ThreadPool::shutdown()
+{
+	std::lock_guard<std::mutex> caller(callerMutex);
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+	std::lock_guard<std::mutex> lock(stateMutex);
+	workers.clear();
+	stopping = false;
+}
+
+}
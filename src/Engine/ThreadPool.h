@@ -0,0 +1,43 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <functional>
+
+namespace OpenXcom
+{
+
+/**
+ * Small pool of worker threads shared by the whole game.
+ * Work is handed out as a "parallel for": the calling thread helps
+ * with the job and only returns when every index has been processed,
+ * so callers never see any concurrency outside of the call itself.
+ * Jobs must only read shared game state, or write to disjoint parts of it.
+ */
+class ThreadPool
+{
+public:
+	/// Calls func(i) for every i in [0, count), spread over the worker threads.
+	static void parallelFor(int count, const std::function<void(int)> &func);
+	/// Gets the number of threads taking part in a job, including the caller.
+	static int getThreadCount();
+	/// Stops and joins the worker threads.
+	static void shutdown();
+};
+
+}
@@ -19,6 +19,7 @@
 #include "Timer.h"
 #include "Game.h"
 #include "Options.h"
+#include "FrameProfiler.h"
 
 namespace OpenXcom
 {
@@ -27,11 +28,13 @@ namespace
 {
 
 const Uint32 accurate = 4;
+/// Milliseconds of game logic run so far.
+Uint32 gameTime = 0;
 Uint32 slowTick()
 {
-	static Uint32 old_time = SDL_GetTicks();
+	static Uint32 old_time = gameTime;
 	static Uint64 false_time = static_cast<Uint64>(old_time) << accurate;
-	Uint64 new_time = ((Uint64)SDL_GetTicks()) << accurate;
+	Uint64 new_time = ((Uint64)gameTime) << accurate;
 	false_time += (new_time - old_time) / Timer::gameSlowSpeed;
 	old_time = new_time;
 	return false_time >> accurate;
@@ -116,6 +119,7 @@ void Timer::think(State* state, Surface* surface)
 	{
 		if ((now - _frameSkipStart) >= _interval)
 		{
+			ProfileScope profile(PHASE_TIMERS);
 			for (int i = 0; i <= maxFrameSkip && isRunning() && (now - _frameSkipStart) >= _interval; ++i)
 			{
 				if (state != 0 && _state != 0)
@@ -137,6 +141,17 @@ void Timer::think(State* state, Surface* surface)
 	}
 }
 
+/**
+ * Moves the clock all timers run on forward. The main loop calls this
+ * once per logic tick, so timers follow the fixed logic step
+ * and not the wall clock.
+ * @param ms Time in milliseconds.
+ */
+void Timer::advanceGameTime(Uint32 ms)
+{
+	gameTime += ms;
+}
+
 /**
  * Changes the timer's interval to a new value.
  * @param interval Interval in milliseconds.
@@ -63,6 +63,8 @@ public:
 	void think(State* state, Surface* surface);
 	/// Sets the timer's interval.
 	void setInterval(Uint32 interval);
+	/// Advances the clock all timers run on.
+	static void advanceGameTime(Uint32 ms);
 	/// Hooks a state action handler to the timer interval.
 	void onTimer(StateHandler handler);
 	/// Hooks a surface action handler to the timer interval.
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Trace.h"
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <SDL.h>
+#include "Logger.h"
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Buffered events are written out once there's this much.
+const size_t FlushSize = 1 << 16;
+
+/// Protects everything below.
+std::mutex traceMutex;
+SDL_RWops *traceFile = nullptr;
+std::string buffer;
+std::chrono::steady_clock::time_point origin;
+int threadCount = 0;
+bool firstEvent = true;
+
+/// Track of the current thread, 0 until it records something.
+thread_local int threadId = 0;
+
+/**
+ * Writes out the buffered events. The trace mutex must be held.
+ */
+void flush()
+{
+	if (traceFile && !buffer.empty())
+	{
+		SDL_RWwrite(traceFile, buffer.data(), buffer.size(), 1);
+	}
+	buffer.clear();
+}
+
+/**
+ * Starts a new event in the buffer. The trace mutex must be held.
+ */
+void separate()
+{
+	if (!firstEvent)
+	{
+		buffer += ",\n";
+	}
+	firstEvent = false;
+}
+
+/**
+ * Gives the current thread its own track, named after the
+ * order threads showed up in. The trace mutex must be held.
+ */
+void registerThread()
+{
+	threadId = ++threadCount;
+	std::ostringstream ss;
+	ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":\"";
+	if (threadId == 1)
+		ss << "main";
+	else
+		ss << "thread " << threadId;
+	ss << "\"}}";
+	separate();
+	buffer += ss.str();
+}
+
+}
+
+std::atomic<bool> Trace::_enabled(false);
+
+/**
+ * Creates the trace file and starts recording zones.
+ * Must be called from the main thread, so it gets the first track.
+ * The trace is also finished when the program exits.
+ * @param filename Path of the JSON file.
+ * @return True if the file could be created.
+ */
+bool Trace::start(const std::string &filename)
+{
+	static bool registered = false;
+	std::lock_guard<std::mutex> lock(traceMutex);
+	if (traceFile)
+	{
+		return true;
+	}
+	// Even SDL1 file IO accepts UTF-8 file names on windows.
+	traceFile = SDL_RWFromFile(filename.c_str(), "wb");
+	if (!traceFile)
+	{
+		Log(LOG_ERROR) << "Failed to write " << filename << ": " << SDL_GetError();
+		return false;
+	}
+	origin = std::chrono::steady_clock::now();
+	buffer = "[\n";
+	firstEvent = true;
+	registerThread();
+	_enabled = true;
+	if (!registered)
+	{
+		registered = true;
+		atexit(Trace::stop);
+	}
+	Log(LOG_INFO) << "Writing trace to " << filename;
+	return true;
+}
+
+/**
+ * Stops recording, writes out the remaining zones
+ * and closes the file. Zones still open are dropped.
+ */
+void Trace::stop()
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	_enabled = false;
+	if (!traceFile)
+	{
+		return;
+	}
+	buffer += "\n]\n";
+	flush();
+	SDL_RWclose(traceFile);
+	traceFile = nullptr;
+}
+
+/**
+ * Records a finished zone on the track of the current thread.
+ * @param name Zone name.
+ * @param start When the zone started.
+ * @param end When the zone ended.
+ */
+void Trace::addZone(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	if (!traceFile)
+	{
+		return;
+	}
+	if (threadId == 0)
+	{
+		registerThread();
+	}
+	std::ostringstream ss;
+	ss << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId
+		<< ",\"ts\":" << std::chrono::duration_cast<std::chrono::microseconds>(start - origin).count()
+		<< ",\"dur\":" << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "}";
+	separate();
+	buffer += ss.str();
+	if (buffer.size() >= FlushSize)
+	{
+		flush();
+	}
+}
+
+}
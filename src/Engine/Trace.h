@@ -0,0 +1,82 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace OpenXcom
+{
+
+/**
+ * Records zones of code as they run and writes them to a file in the
+ * Chrome trace event format, which chrome://tracing and Perfetto show
+ * as a timeline of the whole session, one track per thread.
+ * Zones can be opened on any thread. When tracing is off (the default,
+ * it's turned on from the command line) a zone only checks a flag.
+ */
+class Trace
+{
+	static std::atomic<bool> _enabled;
+public:
+	/// Checks if zones are being recorded.
+	static bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+	/// Starts recording to a file.
+	static bool start(const std::string &filename);
+	/// Stops recording and closes the file.
+	static void stop();
+	/// Records a zone.
+	static void addZone(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+};
+
+/**
+ * Records the time from its creation to its destruction as a trace zone.
+ */
+class TraceZone
+{
+	const char *_name;
+	bool _enabled;
+	std::chrono::steady_clock::time_point _start;
+public:
+	/// Starts a zone, if tracing.
+	TraceZone(const char *name) : _name(name), _enabled(Trace::isEnabled())
+	{
+		if (_enabled)
+		{
+			_start = std::chrono::steady_clock::now();
+		}
+	}
+	/// Ends the zone.
+	~TraceZone()
+	{
+		if (_enabled)
+		{
+			Trace::addZone(_name, _start, std::chrono::steady_clock::now());
+		}
+	}
+	TraceZone(const TraceZone&) = delete;
+	TraceZone &operator=(const TraceZone&) = delete;
+};
+
+#define TRACE_ZONE_NAME2(line) traceZone##line
+#define TRACE_ZONE_NAME(line) TRACE_ZONE_NAME2(line)
+/// Records the rest of the enclosing scope as a trace zone with the given name (a string literal).
+#define TRACE_ZONE(name) OpenXcom::TraceZone TRACE_ZONE_NAME(__LINE__)(name)
+
+}
@@ -19,10 +19,13 @@
 
 #include "Zoom.h"
 
+#include <algorithm>
+#include <functional>
 #include "Surface.h"
 #include "Logger.h"
 #include "Options.h"
 #include "Screen.h"
+#include "ThreadPool.h"
 
 #include "OpenGL.h"
 
@@ -56,6 +59,17 @@
 #include <emmintrin.h> // for SSE2 intrinsics; see http://msdn.microsoft.com/en-us/library/has3d153%28v=vs.71%29.aspx
 #endif
 
+// AVX2 routines are compiled for that target only and picked at runtime, so the build doesn't need -mavx2
+#if (defined(__GNUC__) && (__i386__ || __x86_64__) && !(__e2k__)) || (defined(_MSC_VER) && (_MSC_VER >= 1900) && (defined(_M_IX86) || defined(_M_X64)))
+#define OXCE_ZOOM_AVX2
+#include <immintrin.h>
+#ifdef __GNUC__
+#define ZOOM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ZOOM_TARGET_AVX2
+#endif
+#endif
+
 
 
 namespace OpenXcom
@@ -653,6 +667,256 @@ bool Zoom::haveSSE2()
 
 #endif
 
+/**
+ * Checks the AVX2 feature bit returned by the CPUID instruction,
+ * and that the OS saves the AVX registers on context switches.
+ * @return Can the CPU run AVX2 code?
+ */
+bool Zoom::haveAVX2()
+{
+#if defined(OXCE_ZOOM_AVX2) && defined(__GNUC__)
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+	if (!__get_cpuid(1, CPUInfo, CPUInfo+1, CPUInfo+2, CPUInfo+3))
+	{
+		return false;
+	}
+	// OSXSAVE and AVX
+	if ((CPUInfo[2] & 0x18000000) != 0x18000000)
+	{
+		return false;
+	}
+	unsigned int xcr0, xcr0High;
+	__asm__ ("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+	if ((xcr0 & 0x6) != 0x6)
+	{
+		return false;
+	}
+	if (__get_cpuid_max(0, 0) < 7)
+	{
+		return false;
+	}
+	__cpuid_count(7, 0, CPUInfo[0], CPUInfo[1], CPUInfo[2], CPUInfo[3]);
+	return (CPUInfo[1] & 0x20) ? true : false;
+#elif defined(OXCE_ZOOM_AVX2)
+	int CPUInfo[4];
+	__cpuid(CPUInfo, 1);
+	if ((CPUInfo[2] & 0x18000000) != 0x18000000)
+	{
+		return false;
+	}
+	if ((_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+	__cpuid(CPUInfo, 0);
+	if (CPUInfo[0] < 7)
+	{
+		return false;
+	}
+	__cpuidex(CPUInfo, 7, 0);
+	return (CPUInfo[1] & 0x20) ? true : false;
+#else
+	return false;
+#endif
+}
+
+#ifdef OXCE_ZOOM_AVX2
+/**
+ * Doubles every byte of a vector of 32 pixels.
+ * @param data Source pixels.
+ * @param first Gets the doubled pixels 0-15.
+ * @param second Gets the doubled pixels 16-31.
+ */
+ZOOM_TARGET_AVX2 static inline void doublePixels_AVX2(__m256i data, __m256i &first, __m256i &second)
+{
+	// unpack works on each 128-bit lane, so the halves need to be put back in order
+	__m256i lo = _mm256_unpacklo_epi8(data, data);
+	__m256i hi = _mm256_unpackhi_epi8(data, data);
+	first = _mm256_permute2x128_si256(lo, hi, 0x20);
+	second = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+/**
+ * Optimized 8-bit zoomer for resizing by a factor of 2. Doesn't flip.
+ * Used internally by _zoomSurfaceY() below.
+ * This is an AVX2 version written with Intel intrinsics, any widths and alignments work.
+ *
+ * @param src The surface to zoom (input).
+ * @param dst The zoomed surface (output).
+ * @param yFirst First source row to zoom.
+ * @param yLast Source row after the last one to zoom.
+ */
+ZOOM_TARGET_AVX2 static void zoomSurface2X_AVX2(SDL_Surface *src, SDL_Surface *dst, int yFirst, int yLast)
+{
+	for (int sy = yFirst; sy < yLast; ++sy)
+	{
+		const Uint8 *pixelSrc = (const Uint8*)src->pixels + sy * src->pitch;
+		Uint8 *pixelDst = (Uint8*)dst->pixels + sy * 2 * dst->pitch;
+		Uint8 *pixelDst2 = pixelDst + dst->pitch;
+		int sx = 0;
+		for (; sx + 32 <= src->w; sx += 32)
+		{
+			__m256i first, second;
+			doublePixels_AVX2(_mm256_loadu_si256((const __m256i*)(pixelSrc + sx)), first, second);
+			_mm256_storeu_si256((__m256i*)(pixelDst + sx * 2), first);
+			_mm256_storeu_si256((__m256i*)(pixelDst + sx * 2 + 32), second);
+			_mm256_storeu_si256((__m256i*)(pixelDst2 + sx * 2), first);
+			_mm256_storeu_si256((__m256i*)(pixelDst2 + sx * 2 + 32), second);
+		}
+		for (; sx < src->w; ++sx)
+		{
+			pixelDst[sx * 2] = pixelDst[sx * 2 + 1] = pixelSrc[sx];
+			pixelDst2[sx * 2] = pixelDst2[sx * 2 + 1] = pixelSrc[sx];
+		}
+	}
+	_mm256_zeroupper();
+}
+
+/**
+ * Optimized 8-bit zoomer for resizing by a factor of 4. Doesn't flip.
+ * Used internally by _zoomSurfaceY() below.
+ * This is an AVX2 version written with Intel intrinsics, any widths and alignments work.
+ *
+ * @param src The surface to zoom (input).
+ * @param dst The zoomed surface (output).
+ * @param yFirst First source row to zoom.
+ * @param yLast Source row after the last one to zoom.
+ */
+ZOOM_TARGET_AVX2 static void zoomSurface4X_AVX2(SDL_Surface *src, SDL_Surface *dst, int yFirst, int yLast)
+{
+	for (int sy = yFirst; sy < yLast; ++sy)
+	{
+		const Uint8 *pixelSrc = (const Uint8*)src->pixels + sy * src->pitch;
+		Uint8 *pixelDst = (Uint8*)dst->pixels + sy * 4 * dst->pitch;
+		int sx = 0;
+		for (; sx + 32 <= src->w; sx += 32)
+		{
+			__m256i first, second, out[4];
+			doublePixels_AVX2(_mm256_loadu_si256((const __m256i*)(pixelSrc + sx)), first, second);
+			doublePixels_AVX2(first, out[0], out[1]);
+			doublePixels_AVX2(second, out[2], out[3]);
+			for (int row = 0; row < 4; ++row)
+			{
+				Uint8 *d = pixelDst + row * dst->pitch + sx * 4;
+				for (int i = 0; i < 4; ++i)
+				{
+					_mm256_storeu_si256((__m256i*)(d + i * 32), out[i]);
+				}
+			}
+		}
+		for (; sx < src->w; ++sx)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				Uint8 *d = pixelDst + row * dst->pitch + sx * 4;
+				d[0] = d[1] = d[2] = d[3] = pixelSrc[sx];
+			}
+		}
+	}
+	_mm256_zeroupper();
+}
+#endif
+
+/// Minimal number of rows given to a thread, smaller stripes aren't worth the handoff.
+const int MinStripeRows = 16;
+
+/// Ranges of rows to scale, as the first row and the row after the last one.
+typedef std::vector<std::pair<int, int>> RowBands;
+
+/**
+ * Gets the source rows covered by the changed parts of the image, merged into bands.
+ * @param dirty Changed rectangles of the source, or null if it all changed.
+ * @param rows Number of rows in the source.
+ * @return Bands of rows, in order.
+ */
+static RowBands getRowBands(const std::vector<SDL_Rect> *dirty, int rows)
+{
+	RowBands bands;
+	if (!dirty)
+	{
+		bands.push_back(std::make_pair(0, rows));
+		return bands;
+	}
+	for (const auto &rect : *dirty)
+	{
+		bands.push_back(std::make_pair(std::max<int>(rect.y, 0), std::min<int>(rect.y + rect.h, rows)));
+	}
+	std::sort(bands.begin(), bands.end());
+	RowBands merged;
+	for (const auto &band : bands)
+	{
+		if (band.first >= band.second)
+		{
+			continue;
+		}
+		if (!merged.empty() && band.first <= merged.back().second)
+		{
+			merged.back().second = std::max(merged.back().second, band.second);
+		}
+		else
+		{
+			merged.push_back(band);
+		}
+	}
+	return merged;
+}
+
+/**
+ * Converts bands of source rows to the rows of the zoomed image they end up in.
+ * @param bands Bands of source rows.
+ * @param srcRows Number of rows in the source.
+ * @param dstRows Number of rows in the zoomed image.
+ * @return Bands of zoomed rows.
+ */
+static RowBands zoomRowBands(const RowBands &bands, int srcRows, int dstRows)
+{
+	RowBands zoomed;
+	for (const auto &band : bands)
+	{
+		zoomed.push_back(std::make_pair(
+			(band.first * dstRows + srcRows - 1) / srcRows,
+			(band.second * dstRows + srcRows - 1) / srcRows));
+	}
+	return zoomed;
+}
+
+/**
+ * Runs a routine over horizontal stripes of some bands of an image, spread over the worker threads.
+ * @param bands Bands of rows to process.
+ * @param func Routine taking the first row of a stripe and the row after its last one.
+ */
+static void forEachStripe(const RowBands &bands, const std::function<void(int, int)> &func)
+{
+	int rows = 0;
+	for (const auto &band : bands)
+	{
+		rows += band.second - band.first;
+	}
+	const int count = std::min(ThreadPool::getThreadCount(), rows / MinStripeRows);
+	if (count <= 1)
+	{
+		for (const auto &band : bands)
+		{
+			func(band.first, band.second);
+		}
+		return;
+	}
+	RowBands stripes;
+	for (const auto &band : bands)
+	{
+		const int size = band.second - band.first;
+		const int parts = std::max(1, size * count / rows);
+		for (int i = 0; i < parts; ++i)
+		{
+			stripes.push_back(std::make_pair(band.first + size * i / parts, band.first + size * (i + 1) / parts));
+		}
+	}
+	ThreadPool::parallelFor((int)stripes.size(), [&](int i)
+	{
+		func(stripes[i].first, stripes[i].second);
+	});
+}
+
 /**
  * Wrapper around various software and OpenGL screen buffer pushing functions which zoom.
  * Basically called just from Screen::flip()
@@ -664,8 +928,9 @@ bool Zoom::haveSSE2()
  * @param leftBlackBand Size of left black band in pixels (letterboxing).
  * @param rightBlackBand Size of right black band in pixels (letterboxing).
  * @param glOut OpenGL output.
+ * @param dirty Parts of the source that changed, only they are zoomed. Null to zoom everything.
  */
-void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut)
+void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut, const std::vector<SDL_Rect> *dirty)
 {
 	int dstWidth = dst->w - leftBlackBand - rightBlackBand;
 	int dstHeight = dst->h - topBlackBand - bottomBlackBand;
@@ -683,23 +948,32 @@ void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, in
 	}
 	else if (topBlackBand <= 0 && bottomBlackBand <= 0 && leftBlackBand <= 0 && rightBlackBand <= 0)
 	{
-		_zoomSurfaceY(src, dst, 0, 0);
+		_zoomSurfaceY(src, dst, 0, 0, dirty);
 	}
 	else if (dstWidth == src->w && dstHeight == src->h)
 	{
-		SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)topBlackBand, (Uint16)src->w, (Uint16)src->h};
-		SDL_BlitSurface(src, NULL, dst, &dstrect);
+		for (const auto &band : getRowBands(dirty, src->h))
+		{
+			SDL_Rect srcrect = {0, (Sint16)band.first, (Uint16)src->w, (Uint16)(band.second - band.first)};
+			SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)(topBlackBand + band.first), (Uint16)src->w, (Uint16)(band.second - band.first)};
+			SDL_BlitSurface(src, &srcrect, dst, &dstrect);
+		}
 	}
 	else
 	{
 		SDL_Surface *tmp = SDL_CreateRGBSurface(dst->flags, dstWidth, dstHeight, dst->format->BitsPerPixel, 0, 0, 0, 0);
-		_zoomSurfaceY(src, tmp, 0, 0);
+		_zoomSurfaceY(src, tmp, 0, 0, dirty);
 		if (src->format->palette != NULL)
 		{
 			SDL_SetPalette(tmp, SDL_LOGPAL|SDL_PHYSPAL, src->format->palette->colors, 0, src->format->palette->ncolors);
 		}
-		SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)topBlackBand, (Uint16)tmp->w, (Uint16)tmp->h};
-		SDL_BlitSurface(tmp, NULL, dst, &dstrect);
+		// only the zoomed rows hold anything
+		for (const auto &band : zoomRowBands(getRowBands(dirty, src->h), src->h, tmp->h))
+		{
+			SDL_Rect srcrect = {0, (Sint16)band.first, (Uint16)tmp->w, (Uint16)(band.second - band.first)};
+			SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)(topBlackBand + band.first), (Uint16)tmp->w, (Uint16)(band.second - band.first)};
+			SDL_BlitSurface(tmp, &srcrect, dst, &dstrect);
+		}
 		SDL_FreeSurface(tmp);
 	}
 }
@@ -717,17 +991,19 @@ void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, in
  * @param dst The zoomed surface (output).
  * @param flipx Flag indicating if the image should be horizontally flipped.
  * @param flipy Flag indicating if the image should be vertically flipped.
+ * @param dirty Parts of the source that changed, only their rows are zoomed. Null to zoom everything.
  * @return 0 for success or -1 for error.
  */
-int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy)
+int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy, const std::vector<SDL_Rect> *dirty)
 {
 	int x, y;
 	static Uint32 *sax, *say;
 	Uint32 *csax, *csay;
 	int csx, csy;
-	Uint8 *sp, *dp, *csp;
+	Uint8 *startSrc;
 	int dgap;
 	static bool proclaimed = false;
+	const RowBands bands = getRowBands(flipy ? nullptr : dirty, src->h);
 
 	if (Screen::use32bitScaler())
 	{
@@ -738,7 +1014,10 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 			{
 				if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor)
 				{
-					xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB);
+					forEachStripe(bands, [&](int yFirst, int yLast)
+					{
+						xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB, xbrz::ScalerCfg(), yFirst, yLast);
+					});
 					return 0;
 				}
 			}
@@ -754,23 +1033,32 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 				initDone = true;
 			}
 
-			// HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
+			// HQX_API void HQX_CALLCONV hq2x_32_rb_rows( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
 
 			if (dst->w == src->w * 2 && dst->h == src->h * 2)
 			{
-				hq2x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				forEachStripe(bands, [&](int yFirst, int yLast)
+				{
+					hq2x_32_rb_rows((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+				});
 				return 0;
 			}
 
 			if (dst->w == src->w * 3 && dst->h == src->h * 3)
 			{
-				hq3x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				forEachStripe(bands, [&](int yFirst, int yLast)
+				{
+					hq3x_32_rb_rows((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+				});
 				return 0;
 			}
 
 			if (dst->w == src->w * 4 && dst->h == src->h * 4)
 			{
-				hq4x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
+				forEachStripe(bands, [&](int yFirst, int yLast)
+				{
+					hq4x_32_rb_rows((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+				});
 				return 0;
 			}
 		}
@@ -837,6 +1125,32 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 		else if (dst->w == src->w * 2) return zoomSurface2X_XAxis_32bit(src, dst);
 	}
 	*/
+
+#ifdef OXCE_ZOOM_AVX2
+	if (src->format->BytesPerPixel == 1 && dst->format->BytesPerPixel == 1 && !flipx && !flipy)
+	{
+		static bool _haveAVX2 = haveAVX2();
+
+		if (_haveAVX2 && ((dst->w == src->w * 2 && dst->h == src->h * 2) || (dst->w == src->w * 4 && dst->h == src->h * 4)))
+		{
+			static bool proclaimedAVX2 = false;
+
+			if (!proclaimedAVX2)
+			{
+				Log(LOG_INFO) << "Using AVX2 zoom routine.";
+				proclaimedAVX2 = true;
+			}
+
+			auto zoom = (dst->w == src->w * 2) ? zoomSurface2X_AVX2 : zoomSurface4X_AVX2;
+			forEachStripe(bands, [&](int yFirst, int yLast)
+			{
+				zoom(src, dst, yFirst, yLast);
+			});
+			return 0;
+		}
+	}
+#endif
+
 	if (!proclaimed)
 	{
 		Log(LOG_INFO) << "Using software scaling routine. For best results, try an OpenGL filter.";
@@ -859,12 +1173,11 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	/*
 	* Pointer setup
 	*/
-	sp = csp = (Uint8 *) src->pixels;
-	dp = (Uint8 *) dst->pixels;
+	startSrc = (Uint8 *) src->pixels;
 	dgap = dst->pitch - dst->w;
 
-	if (flipx) csp += (src->w-1);
-	if (flipy) csp  = ( (Uint8*)csp + src->pitch*(src->h-1) );
+	if (flipx) startSrc += (src->w-1);
+	if (flipy) startSrc  = ( (Uint8*)startSrc + src->pitch*(src->h-1) );
 
 	/*
 	* Precalculate row increments
@@ -894,38 +1207,48 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 		csay++;
 	}
 	/*
-	* Draw
+	* Draw, each stripe finds its first source row by summing up the row increments before it
 	*/
-	csay = say;
-	for (y = 0; y < dst->h; y++) {
-		csax = sax;
-		sp = csp;
-		for (x = 0; x < dst->w; x++) {
-			/*
-			* Draw
-			*/
-			*dp = *sp;
+	forEachStripe(zoomRowBands(bands, src->h, dst->h), [&](int yFirst, int yLast)
+	{
+		Uint8 *sp, *dp, *csp;
+		Uint32 *dsax, *dsay;
+
+		csp = startSrc;
+		for (dsay = say; dsay != say + yFirst; dsay++) {
+			csp += (*dsay);
+		}
+		dp = (Uint8 *) dst->pixels + yFirst * dst->pitch;
+		for (int dy = yFirst; dy < yLast; dy++) {
+			dsax = sax;
+			sp = csp;
+			for (int dx = 0; dx < dst->w; dx++) {
+				/*
+				* Draw
+				*/
+				*dp = *sp;
+				/*
+				* Advance source pointers
+				*/
+				sp += (*dsax);
+				dsax++;
+				/*
+				* Advance destination pointer
+				*/
+				dp++;
+			}
 			/*
-			* Advance source pointers
+			* Advance source pointer (for row)
 			*/
-			sp += (*csax);
-			csax++;
+			csp += (*dsay);
+			dsay++;
+
 			/*
-			* Advance destination pointer
+			* Advance destination pointers
 			*/
-			dp++;
+			dp += dgap;
 		}
-		/*
-		* Advance source pointer (for row)
-		*/
-		csp += (*csay);
-		csay++;
-
-		/*
-		* Advance destination pointers
-		*/
-		dp += dgap;
-	}
+	});
 
 	/*
 	* Never remove temp arrays
@@ -34,6 +34,7 @@
 #include "../Engine/Options.h"
 #include "../Engine/Collections.h"
 #include "../Engine/Unicode.h"
+#include "../Engine/FrameProfiler.h"
 #include "Globe.h"
 #include "../Interface/ComboBox.h"
 #include "../Interface/Text.h"
@@ -515,6 +516,20 @@ void GeoscapeState::blit()
 	}
 }
 
+/**
+ * Adds the Geoscape and the Dogfights blitted over it to the blit signature.
+ * @param signature List of values to add to.
+ */
+void GeoscapeState::getBlitSignature(std::vector<int> &signature) const
+{
+	State::getBlitSignature(signature);
+	signature.push_back((int)_dogfights.size());
+	for (auto* dfs : _dogfights)
+	{
+		dfs->getBlitSignature(signature);
+	}
+}
+
 /**
  * Handle key shortcuts.
  * @param action Pointer to an action.
@@ -848,6 +863,7 @@ void GeoscapeState::timeDisplay()
  */
 void GeoscapeState::timeAdvance()
 {
+	ProfileScope profile(PHASE_GEO_TIME);
 	int timeSpan = 0;
 	if (_timeSpeed == _btn5Secs)
 	{
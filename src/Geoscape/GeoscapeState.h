@@ -167,6 +167,8 @@ public:
 	void btnZoomOutRightClick(Action *action);
 	/// Blit method - renders the state and dogfights.
 	void blit() override;
+	/// Adds the Geoscape and Dogfights to the blit signature.
+	void getBlitSignature(std::vector<int> &signature) const override;
 	/// Globe zoom in effect for dogfights.
 	void zoomInEffect();
 	/// Globe zoom out effect for dogfights.
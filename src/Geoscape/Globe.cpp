@@ -53,6 +53,7 @@
 #include "../Mod/Texture.h"
 #include "../Interface/Cursor.h"
 #include "../Engine/Screen.h"
+#include "../Engine/FrameProfiler.h"
 
 namespace OpenXcom
 {
@@ -960,6 +961,7 @@ void Globe::rotate()
  */
 void Globe::draw()
 {
+	ProfileScope profile(PHASE_GEO_GLOBE);
 	if (_redraw)
 	{
 		cachePolygons();
@@ -18,10 +18,12 @@
  */
 
 #include "FpsCounter.h"
+#include <algorithm>
 #include <cmath>
 #include "../Engine/Action.h"
 #include "../Engine/Timer.h"
 #include "../Engine/Options.h"
+#include "../Engine/FrameProfiler.h"
 #include "NumberText.h"
 
 namespace OpenXcom
@@ -34,7 +36,7 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-FpsCounter::FpsCounter(int width, int height, int x, int y) : Surface(width, height, x, y), _frames(0)
+FpsCounter::FpsCounter(int width, int height, int x, int y) : Surface(width, height, x, y), _frames(0), _width0(width), _height0(height), _profiling(false), _color(0)
 {
 	_visible = Options::fpsCounter;
 
@@ -43,6 +45,7 @@ FpsCounter::FpsCounter(int width, int height, int x, int y) : Surface(width, hei
 	_timer->start();
 
 	_text = new NumberText(width, height, x, y);
+	_number = new NumberText(20, 5);
 }
 
 /**
@@ -51,6 +54,7 @@ FpsCounter::FpsCounter(int width, int height, int x, int y) : Surface(width, hei
 FpsCounter::~FpsCounter()
 {
 	delete _text;
+	delete _number;
 	delete _timer;
 }
 
@@ -64,6 +68,7 @@ void FpsCounter::setPalette(const SDL_Color *colors, int firstcolor, int ncolors
 {
 	Surface::setPalette(colors, firstcolor, ncolors);
 	_text->setPalette(colors, firstcolor, ncolors);
+	_number->setPalette(colors, firstcolor, ncolors);
 }
 
 /**
@@ -73,6 +78,8 @@ void FpsCounter::setPalette(const SDL_Color *colors, int firstcolor, int ncolors
 void FpsCounter::setColor(Uint8 color)
 {
 	_text->setColor(color);
+	_number->setColor(color);
+	_color = color;
 }
 
 /**
@@ -93,6 +100,22 @@ void FpsCounter::handle(Action *action)
  */
 void FpsCounter::think()
 {
+	if (Options::oxceFrameProfiler != _profiling)
+	{
+		_profiling = Options::oxceFrameProfiler;
+		FrameProfiler::setEnabled(_profiling);
+		if (_profiling)
+		{
+			resize(PROFILE_WIDTH, PROFILE_HEIGHT);
+			_visible = true;
+		}
+		else
+		{
+			resize(_width0, _height0);
+			_visible = Options::fpsCounter;
+		}
+		_redraw = true;
+	}
 	_timer->think(0, this);
 }
 
@@ -114,11 +137,79 @@ void FpsCounter::draw()
 {
 	Surface::draw();
 	_text->blit(this->getSurface());
+	if (_profiling)
+	{
+		drawProfile();
+	}
 }
 
+/**
+ * Counts a frame as drawn. The profiler
+ * graph moves along with every frame.
+ */
 void FpsCounter::addFrame()
 {
 	_frames++;
+	if (_profiling)
+	{
+		_redraw = true;
+	}
+}
+
+/**
+ * Returns a color for a frame phase, all
+ * shades of the counter color.
+ * @param phase Frame phase.
+ * @return Color index.
+ */
+Uint8 FpsCounter::getPhaseColor(int phase) const
+{
+	return (_color & 0xF0) | ((_color + phase * 3) & 0x0F);
+}
+
+/**
+ * Draws the frame profiler: a graph of the recent frames stacking
+ * up the top level phases (events, think, blit and flip) with one
+ * pixel per millisecond, and below it one row per phase with
+ * its color, number, and min, average and 99th percentile times
+ * in tenths of a millisecond.
+ */
+void FpsCounter::drawProfile()
+{
+	const FramePhase stacked[] = { PHASE_EVENTS, PHASE_THINK, PHASE_BLIT, PHASE_FLIP };
+	for (int x = 0; x < GRAPH_WIDTH; ++x)
+	{
+		int age = GRAPH_WIDTH - 1 - x;
+		int bottom = GRAPH_Y + GRAPH_HEIGHT;
+		for (FramePhase phase : stacked)
+		{
+			int h = std::min(FrameProfiler::getTime(phase, age) / 1000, bottom - GRAPH_Y);
+			if (h > 0)
+			{
+				drawRect(x, bottom - h, 1, h, getPhaseColor(phase));
+				bottom -= h;
+			}
+		}
+	}
+
+	for (int phase = 0; phase < PHASE_COUNT; ++phase)
+	{
+		int y = GRAPH_Y + GRAPH_HEIGHT + 2 + phase * 6;
+		int stats[3];
+		FrameProfiler::getStats((FramePhase)phase, stats[0], stats[1], stats[2]);
+
+		drawRect(0, y, 3, 5, getPhaseColor(phase));
+		_number->setX(5);
+		_number->setY(y);
+		_number->setValue(phase + 1);
+		_number->blit(this->getSurface());
+		for (int i = 0; i < 3; ++i)
+		{
+			_number->setX(15 + i * 20);
+			_number->setValue((stats[i] + 50) / 100);
+			_number->blit(this->getSurface());
+		}
+	}
 }
 
 }
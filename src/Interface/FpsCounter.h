@@ -29,13 +29,24 @@ class Action;
 /**
  * Counts the amount of frames each second
  * and displays them in a NumberText surface.
+ * With the frame profiler on, it also shows a graph of
+ * the recent frames and the times of each frame phase.
  */
 class FpsCounter : public Surface
 {
 private:
-	NumberText *_text;
+	static const int PROFILE_WIDTH = 76, PROFILE_HEIGHT = 41 + 6 * 11;
+	static const int GRAPH_Y = 7, GRAPH_WIDTH = 64, GRAPH_HEIGHT = 32;
+	NumberText *_text, *_number;
 	Timer *_timer;
 	int _frames;
+	int _width0, _height0;
+	bool _profiling;
+	Uint8 _color;
+	/// Gets the color of a frame phase.
+	Uint8 getPhaseColor(int phase) const;
+	/// Draws the frame profiler.
+	void drawProfile();
 public:
 	/// Creates a new FPS counter linked to a game.
 	FpsCounter(int width, int height, int x, int y);
@@ -53,6 +64,7 @@ public:
 	void update();
 	/// Draws the FPS counter.
 	void draw() override;
+	/// Counts a frame drawn.
 	void addFrame();
 };
 
@@ -22,6 +22,8 @@
 #include <functional>
 #include <sstream>
 #include <climits>
+#include <exception>
+#include <memory>
 #include <cassert>
 #include "../version.h"
 #include "../Engine/CrossPlatform.h"
@@ -53,6 +55,8 @@
 #include "../fmath.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Options.h"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/Trace.h"
 #include "../Battlescape/Pathfinding.h"
 #include "RuleCountry.h"
 #include "RuleRegion.h"
@@ -2168,6 +2172,7 @@ static void throwModOnErrorHelper(const std::string& modId, const std::string& e
  */
 void Mod::loadAll()
 {
+	TRACE_ZONE("Mod::loadAll");
 	ModScript parser{ _scriptGlobal, this };
 	const auto& mods = FileMap::getRulesets();
 
@@ -2483,21 +2488,68 @@ void Mod::loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, ModScrip
 	std::sort(sortedRulesetFiles.begin(), sortedRulesetFiles.end(),
 		[](const FileMap::FileRecord& a, const FileMap::FileRecord& b)
 		{ return a.fullpath > b.fullpath; });
-	for (const auto& filerec : sortedRulesetFiles)
-	{
-		Log(LOG_VERBOSE) << "- " << filerec.fullpath;
-		try
-		{
-			_scriptGlobal->fileLoad(filerec.fullpath);
-			loadFile(filerec, parsers);
+	// Parsing the YAML takes most of the time, so each batch of files is parsed on
+	// the worker threads first, then their rules are loaded one by one in order.
+	// Files are read on this thread, as zip archives can't be shared between threads.
+	const size_t batchSize = ThreadPool::getThreadCount() * 4;
+	for (size_t first = 0; first < sortedRulesetFiles.size(); first += batchSize)
+	{
+		const size_t count = std::min(batchSize, sortedRulesetFiles.size() - first);
+		std::vector<RawData> data(count);
+		std::vector<std::unique_ptr<YAML::YamlRootNodeReader>> readers(count);
+		std::vector<std::exception_ptr> errors(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			try
+			{
+				data[i] = sortedRulesetFiles[first + i].getRawData();
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
 		}
-		catch (Exception &e)
+		ThreadPool::parallelFor((int)count, [&](int i)
 		{
-			throw Exception(filerec.fullpath + ": " + std::string(e.what()));
-		}
-		catch (YAML::Exception &e)
+			TRACE_ZONE("Mod::loadMod parse");
+			if (errors[i])
+			{
+				return;
+			}
+			try
+			{
+				readers[i].reset(new YAML::YamlRootNodeReader(data[i], sortedRulesetFiles[first + i].fullpath));
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+			data[i] = RawData();
+		});
+
+		for (size_t i = 0; i < count; ++i)
 		{
-			throw Exception(filerec.fullpath + ": " + std::string(e.what()));
+			const auto& filerec = sortedRulesetFiles[first + i];
+			Log(LOG_VERBOSE) << "- " << filerec.fullpath;
+			try
+			{
+				if (errors[i])
+				{
+					Log(LOG_FATAL) << "Error loading file '" << filerec.fullpath << "'";
+					std::rethrow_exception(errors[i]);
+				}
+				_scriptGlobal->fileLoad(filerec.fullpath);
+				loadFile(filerec, *readers[i], parsers);
+				readers[i].reset();
+			}
+			catch (Exception &e)
+			{
+				throw Exception(filerec.fullpath + ": " + std::string(e.what()));
+			}
+			catch (YAML::Exception &e)
+			{
+				throw Exception(filerec.fullpath + ": " + std::string(e.what()));
+			}
 		}
 	}
 
@@ -2720,13 +2772,14 @@ void Mod::loadConstants(const YAML::YamlNodeReader &reader)
 /**
  * Loads a ruleset's contents from a YAML file.
  * Rules that match pre-existing rules overwrite them.
- * @param filename YAML filename.
+ * @param filerec YAML file.
+ * @param root The file's parsed contents.
  * @param parsers Object with all available parsers.
  */
-void Mod::loadFile(const FileMap::FileRecord &filerec, ModScript &parsers)
+void Mod::loadFile(const FileMap::FileRecord &filerec, const YAML::YamlRootNodeReader &root, ModScript &parsers)
 {
-	YAML::YamlRootNodeReader r = filerec.getYAML();
-	YAML::YamlNodeReader reader = r.useIndex();
+	TRACE_ZONE("Mod::loadFile");
+	YAML::YamlNodeReader reader = root.useIndex();
 
 	auto loadDocInfoHelper = [&](const char* nodeName)
 	{
@@ -345,8 +345,8 @@ private:
 	/// Loads a ruleset from a YAML file that have basic resources configuration.
 	void loadResourceConfigFile(const FileMap::FileRecord &filerec);
 	void loadConstants(const YAML::YamlNodeReader& reader);
-	/// Loads a ruleset from a YAML file.
-	void loadFile(const FileMap::FileRecord &filerec, ModScript &parsers);
+	/// Loads a ruleset from a parsed YAML file.
+	void loadFile(const FileMap::FileRecord &filerec, const YAML::YamlRootNodeReader &root, ModScript &parsers);
 
 	template<typename T>
 	struct RuleFactory
@@ -2402,13 +2402,33 @@ void BattleUnit::clearVisibleUnits()
 bool BattleUnit::addToVisibleTiles(Tile *tile)
 {
 	//Only add once, otherwise we're going to mess up the visibility value and make trouble for the AI (if sneaky).
-	if (_visibleTilesLookup.insert(tile).second)
+	const size_t index = tile->getIndex();
+	const size_t word = index / 64;
+	const uint64_t bit = uint64_t(1) << (index % 64);
+	if (word >= _visibleTilesMask.size())
 	{
-		tile->setVisible(1);
-		_visibleTiles.push_back(tile);
-		return true;
+		_visibleTilesMask.resize(word + 1);
 	}
-	return false;
+	if (_visibleTilesMask[word] & bit)
+	{
+		return false;
+	}
+	_visibleTilesMask[word] |= bit;
+	tile->setVisible(1);
+	_visibleTiles.push_back(tile);
+	return true;
+}
+
+/**
+ * Has this unit marked this tile as within its view?
+ * @param tile Tile to check.
+ * @return True if the tile is in the list of visible tiles.
+ */
+bool BattleUnit::hasVisibleTile(const Tile *tile) const
+{
+	const size_t index = tile->getIndex();
+	const size_t word = index / 64;
+	return word < _visibleTilesMask.size() && (_visibleTilesMask[word] & (uint64_t(1) << (index % 64)));
 }
 
 /**
@@ -2428,8 +2448,8 @@ void BattleUnit::clearVisibleTiles()
 	for (auto* tile : _visibleTiles)
 	{
 		tile->setVisible(-1);
+		_visibleTilesMask[tile->getIndex() / 64] = 0;
 	}
-	_visibleTilesLookup.clear();
 	_visibleTiles.clear();
 }
 
@@ -3412,6 +3432,17 @@ void BattleUnit::setTile(Tile *tile, SavedBattleGame *saveBattleGame)
 
 	_tile = tile;
 
+	// other units paths could go through the tiles we left or now block
+	if (saveBattleGame->getPathfinding())
+	{
+		saveBattleGame->getPathfinding()->invalidateReachable();
+	}
+	// and lines of sight too
+	if (saveBattleGame->getTileEngine())
+	{
+		saveBattleGame->getTileEngine()->invalidateVisibility();
+	}
+
 	updateTileFloorState(saveBattleGame);
 
 	if (!_tile)
@@ -63,7 +63,7 @@ namespace OpenXcom
  */
 SavedBattleGame::SavedBattleGame(Mod *rule, Language *lang, bool isPreview) :
 	_isPreview(isPreview), _craftPos(), _craftZ(0), _craftForPreview(nullptr),
-	_battleState(0), _rule(rule), _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _selectedUnit(0), _undoUnit(nullptr),
+	_battleState(0), _geoscapeSave(nullptr), _rule(rule), _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _selectedUnit(0), _undoUnit(nullptr),
 	_lastSelectedUnit(0), _pathfinding(0), _tileEngine(0),
 	_reinforcementsItemLevel(0), _startingCondition(nullptr), _enviroEffects(nullptr), _ecEnabledFriendly(false), _ecEnabledHostile(false), _ecEnabledNeutral(false),
 	_globalShade(0), _side(FACTION_PLAYER), _turn(0), _bughuntMinTurn(20), _animFrame(0), _nameDisplay(false),
@@ -135,6 +135,7 @@ SavedBattleGame::~SavedBattleGame()
 void SavedBattleGame::load(const YAML::YamlNodeReader& node, Mod *mod, SavedGame* savedGame)
 {
 	const auto& reader = node.useIndex();
+	_geoscapeSave = savedGame;
 	int mapsize_x = reader["width"].readVal(_mapsize_x);
 	int mapsize_y = reader["length"].readVal(_mapsize_y);
 	int mapsize_z = reader["height"].readVal(_mapsize_z);
@@ -649,9 +650,10 @@ void SavedBattleGame::initMap(int mapsize_x, int mapsize_y, int mapsize_z, bool
 
 	_tiles.clear();
 	_tiles.reserve(_mapsize_z * _mapsize_y * _mapsize_x);
+	_tileHotData.reset(_mapsize_z * _mapsize_y * _mapsize_x);
 	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
 	{
-		_tiles.push_back(Tile(getTileCoords(i), this));
+		_tiles.push_back(Tile(getTileCoords(i), this, &_tileHotData, i));
 	}
 
 }
@@ -1523,11 +1525,14 @@ void SavedBattleGame::endTurn()
 		_lastSelectedUnit = nullptr;
 	}
 
-	BattlescapeTally tally = _battleState->getBattleGame()->tallyUnits();
-
-	if ((_turn > _cheatTurn / 2 && tally.liveAliens <= 2) || _turn > _cheatTurn)
+	if (_battleState)
 	{
-		_cheating = true;
+		BattlescapeTally tally = _battleState->getBattleGame()->tallyUnits();
+
+		if ((_turn > _cheatTurn / 2 && tally.liveAliens <= 2) || _turn > _cheatTurn)
+		{
+			_cheating = true;
+		}
 	}
 
 	if (_side == FACTION_PLAYER)
@@ -1604,6 +1609,10 @@ void SavedBattleGame::endTurn()
 	//scripts update
 	newTurnUpdateScripts();
 
+	// fire, smoke and spotting changed, reachable and visible tiles need to be found again
+	_pathfinding->invalidateReachable();
+	_tileEngine->invalidateVisibility();
+
 	//fov check will be done by `BattlescapeGame::endTurn`
 
 	if (_side != FACTION_PLAYER)
@@ -1695,7 +1704,7 @@ const BattlescapeState *SavedBattleGame::getBattleState() const
  */
 BattlescapeGame *SavedBattleGame::getBattleGame()
 {
-	return _battleState->getBattleGame();
+	return _battleState ? _battleState->getBattleGame() : nullptr;
 }
 
 /**
@@ -1704,7 +1713,7 @@ BattlescapeGame *SavedBattleGame::getBattleGame()
  */
 const BattlescapeGame *SavedBattleGame::getBattleGame() const
 {
-	return _battleState->getBattleGame();
+	return _battleState ? _battleState->getBattleGame() : nullptr;
 }
 
 /**
@@ -2379,10 +2388,13 @@ void SavedBattleGame::prepareNewTurn()
 	std::vector<Tile*> tilesOnFire;
 	std::vector<Tile*> tilesOnSmoke;
 
+	const auto& fire = _tileHotData.fire;
+	const auto& smoke = _tileHotData.smoke;
+
 	// prepare a list of tiles on fire
 	for (int i = 0; i < _mapsize_x * _mapsize_y * _mapsize_z; ++i)
 	{
-		if (getTile(i)->getFire() > 0)
+		if (fire[i] > 0)
 		{
 			tilesOnFire.push_back(getTile(i));
 		}
@@ -2443,6 +2455,8 @@ void SavedBattleGame::prepareNewTurn()
 						}
 					}
 				}
+				_pathfinding->invalidateTerrain(tileOnFire->getPosition());
+				getTileEngine()->updateVoxelGrid(tileOnFire->getPosition());
 				getTileEngine()->applyGravity(tileOnFire);
 			}
 		}
@@ -2451,11 +2465,14 @@ void SavedBattleGame::prepareNewTurn()
 	// prepare a list of tiles on fire/with smoke in them (smoke acts as fire intensity)
 	for (int i = 0; i < _mapsize_x * _mapsize_y * _mapsize_z; ++i)
 	{
-		if (getTile(i)->getSmoke() > 0)
+		if (smoke[i] > 0)
 		{
 			tilesOnSmoke.push_back(getTile(i));
 		}
-		getTile(i)->setDangerous(false);
+	}
+	for (auto& tile : _tiles)
+	{
+		tile.setDangerous(false);
 	}
 
 	// now make the smoke spread.
@@ -2515,12 +2532,12 @@ void SavedBattleGame::prepareNewTurn()
 		// do damage to units, average out the smoke, etc.
 		for (int i = 0; i < _mapsize_x * _mapsize_y * _mapsize_z; ++i)
 		{
-			if (getTile(i)->getSmoke() != 0)
+			if (smoke[i] != 0)
 				getTile(i)->prepareNewTurn(getDepth() == 0);
 		}
 	}
 
-	Mod *mod = getBattleState()->getGame()->getMod();
+	Mod *mod = _rule;
 	for (auto* bu : *getUnits())
 	{
 		bu->calculateEnviDamage(mod, this);
@@ -2915,11 +2932,10 @@ void SavedBattleGame::resetTurnCounter()
  */
 void SavedBattleGame::resetTiles()
 {
-	for (int i = 0; i != getMapSizeXYZ(); ++i)
+	const Uint8 keep = ~((1 << O_WESTWALL) | (1 << O_NORTHWALL) | (1 << O_FLOOR));
+	for (auto& discovered : _tileHotData.discovered)
 	{
-		_tiles[i].setDiscovered(false, O_WESTWALL);
-		_tiles[i].setDiscovered(false, O_NORTHWALL);
-		_tiles[i].setDiscovered(false, O_FLOOR);
+		discovered &= keep;
 	}
 }
 
@@ -3020,6 +3036,11 @@ void SavedBattleGame::calculateModuleMap()
  */
 SavedGame *SavedBattleGame::getGeoscapeSave() const
 {
+	if (!_battleState)
+	{
+		// headless battle (e.g. benchmark), use the save we were loaded from
+		return _geoscapeSave;
+	}
 	return _battleState->getGame()->getSavedGame();
 }
 
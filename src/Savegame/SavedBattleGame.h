@@ -72,10 +72,12 @@ private:
 	Craft* _craftForPreview;
 	std::vector<Position> _craftTiles;
 	BattlescapeState *_battleState;
+	SavedGame *_geoscapeSave;
 	Mod *_rule;
 	int _mapsize_x, _mapsize_y, _mapsize_z;
 	std::vector<MapDataSet*> _mapDataSets;
 	std::vector<Tile> _tiles;
+	TileHotData _tileHotData;
 	BattleUnit *_selectedUnit, *_undoUnit, *_lastSelectedUnit;
 	std::vector<Node*> _nodes;
 	std::vector<BattleUnit*> _units;
@@ -303,6 +305,15 @@ public:
 		return &_tiles[i];
 	}
 
+	/**
+	 * Gets the hot state of all tiles, for passes over the whole map.
+	 * @return Arrays indexed by tile index.
+	 */
+	TileHotData& getTileHotData()
+	{
+		return _tileHotData;
+	}
+
 	/**
 	 * Get tile that is below current one (const version).
 	 * @param tile
@@ -47,27 +47,43 @@ Tile::SerializationKey Tile::serializationKey =
  4 + 2*4 + 2*4 + 1 + 1 + 1 // total bytes to save one tile
 };
 
+/**
+ * Resizes all the arrays for the given number of tiles and sets them to their initial values.
+ * @param size Number of tiles on the map.
+ */
+void TileHotData::reset(int size)
+{
+	MapDataIDs noMapData;
+	for (int i = 0; i < O_MAX; ++i)
+	{
+		noMapData.ID[i] = -1;
+		noMapData.SetID[i] = -1;
+	}
+	light.assign(size, std::array<Uint8, LL_MAX>{});
+	fire.assign(size, 0);
+	smoke.assign(size, 0);
+	discovered.assign(size, 0);
+	visible.assign(size, 0);
+	preview.assign(size, -1);
+	tuMarker.assign(size, -1);
+	energyMarker.assign(size, -1);
+	mapData.assign(size, noMapData);
+}
+
 /**
  * constructor
  * @param pos Position.
+ * @param save Battle the tile belongs to.
+ * @param data Arrays with the frequently updated values of all the tiles.
+ * @param index Index of the tile in these arrays.
  */
-Tile::Tile(Position pos, SavedBattleGame* save): _save(save), _pos(pos)
+Tile::Tile(Position pos, SavedBattleGame* save, TileHotData* data, int index): _save(save), _data(data), _index(index), _pos(pos)
 {
 	for (int i = 0; i < O_MAX; ++i)
 	{
 		_objects[i] = 0;
-		_mapData->ID[i] = -1;
-		_mapData->SetID[i] = -1;
 		_objectsCache[i].currentFrame = 0;
 	}
-	for (int layer = 0; layer < LL_MAX; layer++)
-	{
-		_light[layer] = 0;
-	}
-	for (int i = 0; i < O_MAX; ++i)
-	{
-		_objectsCache[i].discovered = 0;
-	}
 	_cache.isNoFloor = 1;
 	_cache.isGravLift = 0;
 	_cache.isLadderOnObject = 0;
@@ -92,18 +108,21 @@ void Tile::load(const YAML::YamlNodeReader& reader)
 	//reader.tryRead("position", _position);
 	for (int i = 0; i < 4; i++)
 	{
-		reader["mapDataID"][i].tryReadVal(_mapData->ID[i]);
-		reader["mapDataSetID"][i].tryReadVal(_mapData->SetID[i]);
+		reader["mapDataID"][i].tryReadVal(_data->mapData[_index].ID[i]);
+		reader["mapDataSetID"][i].tryReadVal(_data->mapData[_index].SetID[i]);
 	}
 
-	reader.tryRead("fire", _fire);
-	reader.tryRead("smoke", _smoke);
+	reader.tryRead("fire", _data->fire[_index]);
+	reader.tryRead("smoke", _data->smoke[_index]);
 	if (const auto& discovered = reader["discovered"])
 	{
 		for (int i = 0; i < 3; i++)
 		{
-			int realTilePart = (i == 2 ? 0 : i - 1); //convert old convention to new one
-			_objectsCache[realTilePart].discovered = (Uint8)discovered[i].readVal<bool>();
+			int realTilePart = (i == 2 ? 0 : i + 1); //convert old convention to new one
+			if (discovered[i].readVal<bool>())
+			{
+				_data->discovered[_index] |= 1 << realTilePart;
+			}
 		}
 	}
 	if (reader["openDoorWest"])
@@ -114,7 +133,7 @@ void Tile::load(const YAML::YamlNodeReader& reader)
 	{
 		_objectsCache[2].currentFrame = 7;
 	}
-	if (_fire || _smoke)
+	if (_data->fire[_index] || _data->smoke[_index])
 	{
 		_animationOffset = RNG::seedless(0, 3);
 	}
@@ -127,25 +146,24 @@ void Tile::load(const YAML::YamlNodeReader& reader)
  */
 void Tile::loadBinary(Uint8 *buffer, Tile::SerializationKey& serKey)
 {
-	_mapData->ID[0] = unserializeInt(&buffer, serKey._mapDataID);
-	_mapData->ID[1] = unserializeInt(&buffer, serKey._mapDataID);
-	_mapData->ID[2] = unserializeInt(&buffer, serKey._mapDataID);
-	_mapData->ID[3] = unserializeInt(&buffer, serKey._mapDataID);
-	_mapData->SetID[0] = unserializeInt(&buffer, serKey._mapDataSetID);
-	_mapData->SetID[1] = unserializeInt(&buffer, serKey._mapDataSetID);
-	_mapData->SetID[2] = unserializeInt(&buffer, serKey._mapDataSetID);
-	_mapData->SetID[3] = unserializeInt(&buffer, serKey._mapDataSetID);
+	auto& mapData = _data->mapData[_index];
+	mapData.ID[0] = unserializeInt(&buffer, serKey._mapDataID);
+	mapData.ID[1] = unserializeInt(&buffer, serKey._mapDataID);
+	mapData.ID[2] = unserializeInt(&buffer, serKey._mapDataID);
+	mapData.ID[3] = unserializeInt(&buffer, serKey._mapDataID);
+	mapData.SetID[0] = unserializeInt(&buffer, serKey._mapDataSetID);
+	mapData.SetID[1] = unserializeInt(&buffer, serKey._mapDataSetID);
+	mapData.SetID[2] = unserializeInt(&buffer, serKey._mapDataSetID);
+	mapData.SetID[3] = unserializeInt(&buffer, serKey._mapDataSetID);
 
-	_smoke = unserializeInt(&buffer, serKey._smoke);
-	_fire = unserializeInt(&buffer, serKey._fire);
+	_data->smoke[_index] = unserializeInt(&buffer, serKey._smoke);
+	_data->fire[_index] = unserializeInt(&buffer, serKey._fire);
 
 	Uint8 boolFields = unserializeInt(&buffer, serKey.boolFields);
-	_objectsCache[O_WESTWALL].discovered = (boolFields & 1) ? 1 : 0;
-	_objectsCache[O_NORTHWALL].discovered = (boolFields & 2) ? 1 : 0;
-	_objectsCache[O_FLOOR].discovered = (boolFields & 4) ? 1 : 0;
+	_data->discovered[_index] = ((boolFields & 1) ? 1 << O_WESTWALL : 0) | ((boolFields & 2) ? 1 << O_NORTHWALL : 0) | ((boolFields & 4) ? 1 << O_FLOOR : 0);
 	_objectsCache[O_WESTWALL].currentFrame = (boolFields & 8) ? 7 : 0;
 	_objectsCache[O_NORTHWALL].currentFrame = (boolFields & 0x10) ? 7 : 0;
-	if (_fire || _smoke)
+	if (_data->fire[_index] || _data->smoke[_index])
 	{
 		_animationOffset = RNG::seedless(0, 3);
 	}
@@ -160,20 +178,20 @@ void Tile::save(YAML::YamlNodeWriter writer) const
 {
 	writer.setAsMap();
 	writer.write("position", _pos);
-	std::vector<int> ids(std::begin(_mapData->ID), std::end(_mapData->ID));
-	std::vector<int> setIds(std::begin(_mapData->SetID), std::end(_mapData->SetID));
+	std::vector<int> ids(std::begin(_data->mapData[_index].ID), std::end(_data->mapData[_index].ID));
+	std::vector<int> setIds(std::begin(_data->mapData[_index].SetID), std::end(_data->mapData[_index].SetID));
 	writer.write("mapDataID", ids);
 	writer.write("mapDataSetID", setIds);
-	if (_smoke)
-		writer.write("smoke", _smoke);
-	if (_fire)
-		writer.write("fire", _fire);
-	if (_objectsCache[O_FLOOR].discovered || _objectsCache[O_WESTWALL].discovered || _objectsCache[O_NORTHWALL].discovered)
+	if (_data->smoke[_index])
+		writer.write("smoke", _data->smoke[_index]);
+	if (_data->fire[_index])
+		writer.write("fire", _data->fire[_index]);
+	if (isDiscovered(O_FLOOR) || isDiscovered(O_WESTWALL) || isDiscovered(O_NORTHWALL))
 	{
 		throw Exception("Obsolete code");
 //		for (int i = O_FLOOR; i <= O_NORTHWALL; i++)
 //		{
-//			node["discovered"].push_back(_objectsCache[i].discovered);
+//			node["discovered"].push_back(isDiscovered((TilePart)i));
 //		}
 	}
 	if (isUfoDoorOpen(O_WESTWALL))
@@ -192,19 +210,20 @@ void Tile::save(YAML::YamlNodeWriter writer) const
  */
 void Tile::saveBinary(Uint8** buffer) const
 {
-	serializeInt(buffer, serializationKey._mapDataID, _mapData->ID[0]);
-	serializeInt(buffer, serializationKey._mapDataID, _mapData->ID[1]);
-	serializeInt(buffer, serializationKey._mapDataID, _mapData->ID[2]);
-	serializeInt(buffer, serializationKey._mapDataID, _mapData->ID[3]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapData->SetID[0]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapData->SetID[1]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapData->SetID[2]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapData->SetID[3]);
+	const auto& mapData = _data->mapData[_index];
+	serializeInt(buffer, serializationKey._mapDataID, mapData.ID[0]);
+	serializeInt(buffer, serializationKey._mapDataID, mapData.ID[1]);
+	serializeInt(buffer, serializationKey._mapDataID, mapData.ID[2]);
+	serializeInt(buffer, serializationKey._mapDataID, mapData.ID[3]);
+	serializeInt(buffer, serializationKey._mapDataSetID, mapData.SetID[0]);
+	serializeInt(buffer, serializationKey._mapDataSetID, mapData.SetID[1]);
+	serializeInt(buffer, serializationKey._mapDataSetID, mapData.SetID[2]);
+	serializeInt(buffer, serializationKey._mapDataSetID, mapData.SetID[3]);
 
-	serializeInt(buffer, serializationKey._smoke, _smoke);
-	serializeInt(buffer, serializationKey._fire, _fire);
+	serializeInt(buffer, serializationKey._smoke, _data->smoke[_index]);
+	serializeInt(buffer, serializationKey._fire, _data->fire[_index]);
 
-	Uint8 boolFields = (_objectsCache[O_WESTWALL].discovered?1:0) + (_objectsCache[O_NORTHWALL].discovered?2:0) + (_objectsCache[O_FLOOR].discovered?4:0);
+	Uint8 boolFields = (isDiscovered(O_WESTWALL)?1:0) + (isDiscovered(O_NORTHWALL)?2:0) + (isDiscovered(O_FLOOR)?4:0);
 	boolFields |= isUfoDoorOpen(O_WESTWALL) ? 8 : 0; // west
 	boolFields |= isUfoDoorOpen(O_NORTHWALL) ? 0x10 : 0; // north?
 	serializeInt(buffer, serializationKey.boolFields, boolFields);
@@ -220,8 +239,8 @@ void Tile::saveBinary(Uint8** buffer) const
 void Tile::setMapData(MapData *dat, int mapDataID, int mapDataSetID, TilePart part)
 {
 	_objects[part] = dat;
-	_mapData->ID[part] = mapDataID;
-	_mapData->SetID[part] = mapDataSetID;
+	_data->mapData[_index].ID[part] = mapDataID;
+	_data->mapData[_index].SetID[part] = mapDataSetID;
 	_objectsCache[part].isDoor = dat ? dat->isDoor() : 0;
 	_objectsCache[part].isUfoDoor = dat ? dat->isUFODoor() : 0;
 	_objectsCache[part].offsetY = dat ? dat->getYOffset() : 0;
@@ -277,8 +296,8 @@ void Tile::setMapData(MapData *dat, int mapDataID, int mapDataSetID, TilePart pa
  */
 void Tile::getMapData(int *mapDataID, int *mapDataSetID, TilePart part) const
 {
-	*mapDataID = _mapData->ID[part];
-	*mapDataSetID = _mapData->SetID[part];
+	*mapDataID = _data->mapData[_index].ID[part];
+	*mapDataSetID = _data->mapData[_index].SetID[part];
 }
 
 /**
@@ -287,7 +306,7 @@ void Tile::getMapData(int *mapDataID, int *mapDataSetID, TilePart part) const
  */
 bool Tile::isVoid() const
 {
-	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && _smoke == 0 && _inventory.empty();
+	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && _data->smoke[_index] == 0 && _inventory.empty();
 }
 
 /**
@@ -384,7 +403,7 @@ int Tile::openDoor(TilePart part, BattleUnit *unit, BattleActionType reserve, bo
 			return 4;
 		if (_unit && _unit != unit && _unit->getPosition() != getPosition())
 			return -1;
-		setMapData(_objects[part]->getDataset()->getObject(_objects[part]->getAltMCD()), _objects[part]->getAltMCD(), _mapData->SetID[part],
+		setMapData(_objects[part]->getDataset()->getObject(_objects[part]->getAltMCD()), _objects[part]->getAltMCD(), _data->mapData[_index].SetID[part],
 				   _objects[part]->getDataset()->getObject(_objects[part]->getAltMCD())->getObjectType());
 		setMapData(0, -1, -1, part);
 		return 0;
@@ -428,13 +447,20 @@ int Tile::closeUfoDoor()
  */
 void Tile::setDiscovered(bool flag, TilePart part)
 {
-	if (_objectsCache[part].discovered != flag)
+	auto& discovered = _data->discovered[_index];
+	if (isDiscovered(part) != flag)
 	{
-		_objectsCache[part].discovered = flag;
-		if (part == O_FLOOR && flag == true)
+		if (flag)
+		{
+			discovered |= 1 << part;
+			if (part == O_FLOOR)
+			{
+				discovered |= (1 << O_WESTWALL) | (1 << O_NORTHWALL);
+			}
+		}
+		else
 		{
-			_objectsCache[O_WESTWALL].discovered = true;
-			_objectsCache[O_NORTHWALL].discovered = true;
+			discovered &= ~(1 << part);
 		}
 	}
 }
@@ -446,7 +472,7 @@ void Tile::setDiscovered(bool flag, TilePart part)
  */
 bool Tile::isDiscovered(TilePart part) const
 {
-	return _objectsCache[part].discovered;
+	return _data->discovered[_index] & (1 << part);
 }
 
 
@@ -456,7 +482,7 @@ bool Tile::isDiscovered(TilePart part) const
  */
 void Tile::resetLight(LightLayers layer)
 {
-	_light[layer] = 0;
+	_data->light[_index][layer] = 0;
 }
 
 /**
@@ -467,7 +493,7 @@ void Tile::resetLightMulti(LightLayers layer)
 {
 	for (int l = layer; l < LL_MAX; l++)
 	{
-		_light[l] = 0;
+		_data->light[_index][l] = 0;
 	}
 }
 
@@ -478,8 +504,8 @@ void Tile::resetLightMulti(LightLayers layer)
  */
 void Tile::addLight(int light, LightLayers layer)
 {
-	if (_light[layer] < light)
-		_light[layer] = light;
+	if (_data->light[_index][layer] < light)
+		_data->light[_index][layer] = light;
 }
 
 /**
@@ -489,7 +515,7 @@ void Tile::addLight(int light, LightLayers layer)
  */
 int Tile::getLight(LightLayers layer) const
 {
-	return _light[layer];
+	return _data->light[_index][layer];
 }
 
 int Tile::getLightMulti(LightLayers layer) const
@@ -498,8 +524,8 @@ int Tile::getLightMulti(LightLayers layer) const
 
 	for (int l = layer; l >= 0; --l)
 	{
-		if (_light[l] > light)
-			light = _light[l];
+		if (_data->light[_index][l] > light)
+			light = _data->light[_index][l];
 	}
 
 	return light;
@@ -517,8 +543,8 @@ int Tile::getShade() const
 
 	for (int layer = 0; layer < LL_MAX; layer++)
 	{
-		if (_light[layer] > light)
-			light = _light[layer];
+		if (_data->light[_index][layer] > light)
+			light = _data->light[_index][layer];
 	}
 
 	return std::max(0, 15 - light);
@@ -541,7 +567,7 @@ bool Tile::destroy(TilePart part, SpecialTileType type)
 			return false;
 		_objective = _objects[part]->getSpecialType() == type;
 		MapData *originalPart = _objects[part];
-		int originalMapDataSetID = _mapData->SetID[part];
+		int originalMapDataSetID = _data->mapData[_index].SetID[part];
 		setMapData(0, -1, -1, part);
 		if (originalPart->getDieMCD())
 		{
@@ -664,8 +690,10 @@ int Tile::getFuel(TilePart part) const
 /*
  * Ignite starts fire on a tile, it will burn <fuel> rounds. Fuel of a tile is the highest fuel of its objects.
  * NOT the sum of the fuel of the objects!
+ * @param power Power of the fire.
+ * @return True if the tile caught fire.
  */
-void Tile::ignite(int power)
+bool Tile::ignite(int power)
 {
 	if (getFlammability() != 255)
 	{
@@ -676,15 +704,17 @@ void Tile::ignite(int power)
 		}
 		if (RNG::percent(power) && getFuel())
 		{
-			if (_fire == 0)
+			if (_data->fire[_index] == 0)
 			{
-				_smoke = 15 - Clamp(getFlammability() / 10, 1, 12);
+				_data->smoke[_index] = 15 - Clamp(getFlammability() / 10, 1, 12);
 				_overlaps = 1;
-				_fire = getFuel() + 1;
+				_data->fire[_index] = getFuel() + 1;
 				_animationOffset = RNG::generate(0,3);
+				return true;
 			}
 		}
 	}
+	return false;
 }
 
 /**
@@ -759,7 +789,7 @@ BattleUnit *Tile::getOverlappingUnit(const SavedBattleGame *saveBattleGame, Tile
  */
 void Tile::setFire(int fire)
 {
-	_fire = Clamp(fire, 0, 255);
+	_data->fire[_index] = Clamp(fire, 0, 255);
 	_animationOffset = RNG::generate(0,3);
 }
 
@@ -769,7 +799,7 @@ void Tile::setFire(int fire)
  */
 int Tile::getFire() const
 {
-	return _fire;
+	return _data->fire[_index];
 }
 
 /**
@@ -778,15 +808,15 @@ int Tile::getFire() const
  */
 void Tile::addSmoke(int smoke)
 {
-	if (_fire == 0)
+	if (_data->fire[_index] == 0)
 	{
 		if (_overlaps == 0)
 		{
-			_smoke = Clamp(_smoke + smoke, 1, 15);
+			_data->smoke[_index] = Clamp(_data->smoke[_index] + smoke, 1, 15);
 		}
 		else
 		{
-			_smoke += smoke;
+			_data->smoke[_index] += smoke;
 		}
 		_animationOffset = RNG::generate(0,3);
 		addOverlap();
@@ -799,7 +829,7 @@ void Tile::addSmoke(int smoke)
  */
 void Tile::setSmoke(int smoke)
 {
-	_smoke = Clamp(smoke, 0, 255);
+	_data->smoke[_index] = Clamp(smoke, 0, 255);
 	_animationOffset = RNG::generate(0,3);
 }
 
@@ -810,7 +840,7 @@ void Tile::setSmoke(int smoke)
  */
 int Tile::getSmoke() const
 {
-	return _smoke;
+	return _data->smoke[_index];
 }
 
 /**
@@ -906,7 +936,7 @@ static inline void applyEnvi(BattleUnit* unit, int smoke, int fire, bool smokeDa
 			//and avoid setting fire elementals on fire
 			if (unit->getSpecialAbility() != SPECAB_BURNFLOOR && unit->getSpecialAbility() != SPECAB_BURN_AND_EXPLODE)
 			{
-				// _smoke becomes our damage value
+				// smoke becomes our damage value
 				unit->setEnviFire(smoke);
 			}
 		}
@@ -926,18 +956,20 @@ static inline void applyEnvi(BattleUnit* unit, int smoke, int fire, bool smokeDa
  */
 void Tile::prepareNewTurn(bool smokeDamage)
 {
+	auto& smoke = _data->smoke[_index];
+	const auto fire = _data->fire[_index];
 	// we've received new smoke in this turn, but we're not on fire, average out the smoke.
-	if ( _overlaps != 0 && _smoke != 0 && _fire == 0)
+	if ( _overlaps != 0 && smoke != 0 && fire == 0)
 	{
-		_smoke = Clamp((_smoke / _overlaps) - 1, 0, 15);
+		smoke = Clamp((smoke / _overlaps) - 1, 0, 15);
 	}
 	// if we still have smoke/fire
-	if (_smoke)
+	if (smoke)
 	{
-		applyEnvi(_unit, _smoke, _fire, smokeDamage);
+		applyEnvi(_unit, smoke, fire, smokeDamage);
 		for (auto* bi : _inventory)
 		{
-			applyEnvi(bi->getUnit(), _smoke, _fire, smokeDamage);
+			applyEnvi(bi->getUnit(), smoke, fire, smokeDamage);
 		}
 	}
 	_overlaps = 0;
@@ -977,7 +1009,7 @@ int Tile::getMarkerColor() const
  */
 void Tile::setVisible(int visibility)
 {
-	_visible += visibility;
+	_data->visible[_index] += visibility;
 }
 
 /**
@@ -986,7 +1018,7 @@ void Tile::setVisible(int visibility)
  */
 int Tile::getVisible() const
 {
-	return _visible;
+	return _data->visible[_index];
 }
 
 /**
@@ -995,7 +1027,7 @@ int Tile::getVisible() const
  */
 void Tile::setPreview(int dir)
 {
-	_preview = dir;
+	_data->preview[_index] = dir;
 }
 
 /**
@@ -1004,7 +1036,7 @@ void Tile::setPreview(int dir)
  */
 int Tile::getPreview() const
 {
-	return _preview;
+	return _data->preview[_index];
 }
 
 /**
@@ -1013,7 +1045,7 @@ int Tile::getPreview() const
  */
 void Tile::setTUMarker(int tu)
 {
-	_TUMarker = tu;
+	_data->tuMarker[_index] = tu;
 }
 
 /**
@@ -1022,7 +1054,7 @@ void Tile::setTUMarker(int tu)
  */
 int Tile::getTUMarker() const
 {
-	return _TUMarker;
+	return _data->tuMarker[_index];
 }
 
 /**
@@ -1031,7 +1063,7 @@ int Tile::getTUMarker() const
  */
 void Tile::setEnergyMarker(int energy)
 {
-       _EnergyMarker = energy;
+       _data->energyMarker[_index] = energy;
 }
 
 /**
@@ -1040,7 +1072,7 @@ void Tile::setEnergyMarker(int energy)
  */
 int Tile::getEnergyMarker() const
 {
-       return _EnergyMarker;
+       return _data->energyMarker[_index];
 }
 
 
@@ -17,6 +17,7 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <array>
 #include <vector>
 #include <memory>
 #include "../Engine/Surface.h"
@@ -47,6 +48,39 @@ enum TileUnitOverlapping : int
 	TUO_ALWAYS = 0,
 };
 
+/**
+ * Values of all the tiles of a battle that map wide passes read and update,
+ * like light, fire, smoke and visibility. Each value has its own array indexed
+ * by tile index, so these passes only touch the bytes they need.
+ * Tiles still hand them out through their usual accessors.
+ */
+struct TileHotData
+{
+	/**
+	 * Cache of ID for tile parts used to save and load.
+	 */
+	struct MapDataIDs
+	{
+		int ID[O_MAX];
+		int SetID[O_MAX];
+	};
+
+	std::vector<std::array<Uint8, LL_MAX>> light;
+	std::vector<Uint8> fire;
+	std::vector<Uint8> smoke;
+	/// One bit for each tile part.
+	std::vector<Uint8> discovered;
+	std::vector<Sint16> visible;
+	std::vector<Sint8> preview;
+	std::vector<Sint16> tuMarker;
+	std::vector<Sint16> energyMarker;
+	/// Only used to save and load, kept here to avoid an allocation for every tile.
+	std::vector<MapDataIDs> mapData;
+
+	/// Sets the number of tiles, with everything back to the initial values.
+	void reset(int size);
+};
+
 /**
  * Basic element of which a battle map is build.
  * @sa http://www.ufopaedia.org/index.php?title=MAPS
@@ -74,14 +108,6 @@ public:
 
 	static const int NOT_CALCULATED = -1;
 
-	/**
-	 * Cache of ID for tile parts used to save and load.
-	 */
-	struct TileMapDataCache
-	{
-		int ID[O_MAX];
-		int SetID[O_MAX];
-	};
 	/**
 	 * Cached data that belongs to each tile object
 	 */
@@ -89,7 +115,6 @@ public:
 	{
 		Sint8 offsetY;
 		Uint8 currentFrame:4;
-		Uint8 discovered:1;
 		Uint8 isUfoDoor:1;
 		Uint8 isDoor:1;
 		Uint8 isBackTileObject:1;
@@ -114,29 +139,23 @@ protected:
 	MapData *_objects[O_MAX];
 	BattleUnit *_unit = nullptr;
 	std::vector<BattleItem *> _inventory;
-	std::unique_ptr<TileMapDataCache> _mapData = std::make_unique<TileMapDataCache>();
+	TileHotData *_data;
+	int _index;
 	SurfaceRaw<const Uint8> _currentSurface[O_MAX] = { };
 	TileObjectCache _objectsCache[O_MAX] = { };
 	TileCache _cache = { };
 	Position _pos;
-	Uint8 _light[LL_MAX];
-	Uint8 _fire = 0;
-	Uint8 _smoke = 0;
 	Uint8 _markerColor = 0;
 	Uint8 _animationOffset = 0;
 	Uint8 _obstacle = 0;
 	Uint8 _explosiveType = 0;
 	Sint16 _explosive = 0;
-	Sint16 _visible = 0;
-	Sint16 _TUMarker = -1;
-	Sint16 _EnergyMarker = -1;
-	Sint8 _preview = -1;
 	Uint8 _overlaps = 0;
 
 
 public:
 	/// Creates a tile.
-	Tile(Position pos, SavedBattleGame* save);
+	Tile(Position pos, SavedBattleGame* save, TileHotData* data, int index);
 	/// Copy constructor.
 	Tile(Tile&&) = default;
 	/// Cleans up a tile.
@@ -232,6 +251,15 @@ public:
 		return _pos;
 	}
 
+	/**
+	 * Gets the tile's index in the battle.
+	 * @return index
+	 */
+	int getIndex() const
+	{
+		return _index;
+	}
+
 	/// Gets the floor object footstep sound.
 	int getFootstepSound(Tile *tileBelow) const;
 	/// Open a door, returns the ID, 0(normal), 1(ufo) or -1 if no door opened.
@@ -364,7 +392,7 @@ public:
 	/// Get turns to burn of part
 	int getFuel(TilePart part) const;
 	/// attempt to set the tile on fire, sets overlaps to one if successful.
-	void ignite(int power);
+	bool ignite(int power);
 	/// Get fire and smoke animation offset.
 	int getAnimationOffset() const;
 	/// Add item
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <exception>
+#include <chrono>
+#include "version.h"
+#include "Engine/Exception.h"
+#include "Engine/Logger.h"
+#include "Engine/CrossPlatform.h"
+#include "Engine/Options.h"
+#include "Engine/FileMap.h"
+#include "Engine/Language.h"
+#include "Engine/ThreadPool.h"
+#include "Mod/Mod.h"
+#include "Savegame/SavedGame.h"
+#include "Savegame/SavedBattleGame.h"
+#include "Battlescape/BattlescapeBenchmark.h"
+
+/**
+ * Headless battlescape benchmark.
+ *
+ * Usage: openxcom-bench -load <battle save> [-turns <number>] [other openxcom options]
+ *
+ * Loads the mods from the options and a save made on the battlescape,
+ * then lets the AI play every side for the given number of turns
+ * without any video, and prints where the time went.
+ */
+
+using namespace OpenXcom;
+
+int main(int argc, char *argv[])
+{
+	YAML::setGlobalErrorHandler();
+	CrossPlatform::processArgs(argc, argv);
+
+	int turns = 10;
+	auto& args = CrossPlatform::getArgs();
+	for (size_t i = 1; i + 1 < args.size(); ++i)
+	{
+		if (args[i] == "-turns" || args[i] == "--turns")
+		{
+			turns = std::max(1, atoi(args[i + 1].c_str()));
+		}
+	}
+
+	if (!Options::init())
+		return EXIT_SUCCESS;
+	if (Options::getLoadThisSave().empty())
+	{
+		std::cerr << "Usage: openxcom-bench -load <battle save> [-turns <number>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	Options::mute = true;
+	Options::newSeedOnLoad = false; // same save, same dice
+
+	Mod *mod = 0;
+	Language *lang = 0;
+	SavedGame *save = 0;
+	int result = EXIT_SUCCESS;
+	try
+	{
+		auto start = std::chrono::steady_clock::now();
+		Options::updateMods();
+		Mod::resetGlobalStatics();
+		mod = new Mod();
+		mod->loadAll();
+		lang = new Language();
+
+		save = new SavedGame();
+		save->load(Options::getLoadThisSave(), mod, lang);
+		SavedBattleGame *battle = save->getSavedBattle();
+		if (!battle)
+		{
+			throw Exception(Options::getLoadThisSave() + " is not a battlescape save");
+		}
+		battle->loadMapResources(mod);
+		std::chrono::duration<double> loading = std::chrono::steady_clock::now() - start;
+
+		BattlescapeBenchmark bench(battle);
+		bench.run(turns);
+
+		std::cout << "OpenXcom " << OPENXCOM_VERSION_SHORT << " battlescape benchmark" << std::endl;
+		std::cout << "save: " << Options::getLoadThisSave() << ", map: " << battle->getMapSizeX() << "x" << battle->getMapSizeY() << "x" << battle->getMapSizeZ()
+			<< ", units: " << battle->getUnits()->size() << ", loading: " << loading.count() << " s" << std::endl;
+		bench.report(std::cout);
+	}
+	catch (std::exception &e)
+	{
+		Log(LOG_ERROR) << e.what();
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		result = EXIT_FAILURE;
+	}
+
+	delete save;
+	delete lang;
+	delete mod;
+	ThreadPool::shutdown();
+	FileMap::clear(true, false);
+	return result;
+}
+
+namespace OpenXcom
+{
+	Exception::Exception(const std::string &msg) : runtime_error(msg) {
+#ifdef DUMP_CORE
+		__builtin_trap();
+#endif
+	}
+}
@@ -26,6 +26,9 @@
 #include "Engine/Game.h"
 #include "Engine/Options.h"
 #include "Engine/FileMap.h"
+#include "Engine/ThreadPool.h"
+#include "Engine/Trace.h"
+#include "Engine/AsyncLog.h"
 #include "Menu/StartState.h"
 
 /** @mainpage
@@ -119,6 +122,8 @@ int main(int argc, char *argv[])
 	CrossPlatform::processArgs(argc, argv);
 	if (!Options::init())
 		return EXIT_SUCCESS;
+	if (!Options::getTraceFile().empty())
+		Trace::start(Options::getTraceFile());
 	std::ostringstream title;
 	title << "OpenXcom " << OPENXCOM_VERSION_SHORT << OPENXCOM_VERSION_GIT;
 	Options::baseXResolution = Options::displayWidth;
@@ -133,6 +138,9 @@ int main(int argc, char *argv[])
 
 	// Comment those two for faster exit.
 	delete game;
+	ThreadPool::shutdown();
+	Trace::stop();
+	AsyncLog::stop();
 	FileMap::clear(true, false); // make valgrind happy
 
 	if (startUpdate)